@@ -5,6 +5,7 @@
 
 #include <asm-generic/errno-base.h>
 #include <cerrno>
+#include <fcntl.h>
 #include <functional>
 #include <unistd.h>
 
@@ -13,6 +14,11 @@ Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reusepor
     , acceptSocket_(Socket::createNonblocking()) // socket
     , acceptChannel_(loop, acceptSocket_.fd())
     , listenning_(false)
+    , acceptBatch_(kDefaultAcceptBatch)
+    , idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+    , accepted_(0)
+    , failed_(0)
+    , rejected_(0)
 {
     acceptSocket_.setReuseAddr(true);
     acceptSocket_.setReusePort(reuseport);
@@ -26,6 +32,7 @@ Acceptor::~Acceptor()
 {
     acceptChannel_.disableAll();
     acceptChannel_.remove();
+    ::close(idleFd_);
 }
 
 void Acceptor::listen()
@@ -35,21 +42,61 @@ void Acceptor::listen()
     acceptChannel_.enableReading(); // acceptChannel_ => Poller
 }
 
+AcceptStats Acceptor::stats() const
+{
+    AcceptStats stats;
+    stats.accepted = accepted_.load(std::memory_order_relaxed);
+    stats.failed = failed_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    return stats;
+}
+
 // listenfd有事件发生，就是有新用户连接
+// 一次最多accept acceptBatch_个连接，直到EAGAIN，不必每个连接都经过一次epoll_wait
 void Acceptor::handleRead()
 {
-    InetAddress peerAddr;
-    int connfd = acceptSocket_.accept(&peerAddr);
-    if (connfd >= 0) {
-        if (newConnectionCallback_) {
-            newConnectionCallback_(connfd, peerAddr); // 轮询找到subloop，唤醒并分发当前新客户端的Channel
-        } else {
-            ::close(connfd);
+    for (int i = 0; i < acceptBatch_; ++i) {
+        InetAddress peerAddr;
+        int connfd = acceptSocket_.accept(&peerAddr);
+        if (connfd >= 0) {
+            accepted_.fetch_add(1, std::memory_order_relaxed);
+            if (newConnectionCallback_) {
+                newConnectionCallback_(connfd, peerAddr); // 轮询找到subloop，唤醒并分发当前新客户端的Channel
+            } else {
+                ::close(connfd);
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
         }
-    } else {
-        LOG_ERROR("%s-%s-%d accept error: %d\n", __FILE__, __FUNCTION__, __LINE__, errno);
-        if (errno == EMFILE) {
+
+        int savedErrno = errno;
+        if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+            break; // 全连接队列已经取空
+        }
+
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        if (savedErrno == EMFILE || savedErrno == ENFILE) {
             LOG_ERROR("%s-%s-%d accept reached limit\n", __FILE__, __FUNCTION__, __LINE__);
+            rejectWithIdleFd();
+        } else if (savedErrno == ECONNABORTED || savedErrno == EINTR) {
+            // 对端在accept之前就断开了，继续取下一个
+        } else {
+            LOG_ERROR("%s-%s-%d accept error: %d\n", __FILE__, __FUNCTION__, __LINE__, savedErrno);
+            break;
         }
     }
-}
\ No newline at end of file
+}
+
+void Acceptor::rejectWithIdleFd()
+{
+    if (idleFd_ < 0) {
+        return;
+    }
+    ::close(idleFd_);
+    idleFd_ = ::accept(acceptSocket_.fd(), nullptr, nullptr);
+    if (idleFd_ >= 0) {
+        ::close(idleFd_);
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+    }
+    idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
@@ -7,31 +7,55 @@
 #include "Socket.h"
 #include "noncopyable.h"
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 
 class EventLoop;
 class InetAddress;
 
+// accept相关的统计
+struct AcceptStats {
+    uint64_t accepted = 0; // accept成功的连接数
+    uint64_t failed = 0; // accept出错的次数，不包括EAGAIN
+    uint64_t rejected = 0; // accept之后直接关闭的连接数，fd用完或者没有设置回调
+};
+
 class Acceptor : noncopyable {
 public:
     using NewConnectionCallback = std::function<void(int sockfd, const InetAddress&)>;
 
+    static const int kDefaultAcceptBatch = 16;
+
     Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport);
     ~Acceptor();
 
     void setNewConnectionCallback(const NewConnectionCallback& cb) { newConnectionCallback_ = std::move(cb); }
+    // 每次listenfd可读时最多accept的连接数，连接风暴时减少epoll_wait的次数
+    void setAcceptBatch(int batch) { acceptBatch_ = batch > 0 ? batch : 1; }
 
     bool listenning() const { return listenning_; }
     void listen();
 
+    // 可以在其他线程读取
+    AcceptStats stats() const;
+
 private:
     void handleRead();
-    
+    // 进程fd用完时，用预留的idleFd_ accept一个连接并立刻关闭，避免LT模式下listenfd一直可读空转
+    void rejectWithIdleFd();
+
     EventLoop* loop_; // Acceptor使用的是用户定义的baseloop，也即mainReactor
     Socket acceptSocket_;
     Channel acceptChannel_;
     NewConnectionCallback newConnectionCallback_;
     bool listenning_;
+    int acceptBatch_;
+    int idleFd_; // 预留的空闲fd
+
+    std::atomic<uint64_t> accepted_;
+    std::atomic<uint64_t> failed_;
+    std::atomic<uint64_t> rejected_;
 };
 
 #endif
\ No newline at end of file
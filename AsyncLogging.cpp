@@ -0,0 +1,136 @@
+#include "AsyncLogging.h"
+#include "LogFile.h"
+#include "Timestamp.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+AsyncLogging::AsyncLogging(const std::string& basename, off_t rollSize, int flushInterval)
+    : flushInterval_(flushInterval)
+    , basename_(basename)
+    , rollSize_(rollSize)
+    , running_(false)
+    , thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging")
+    , currentBuffer_(new LogBuffer)
+    , nextBuffer_(new LogBuffer)
+{
+    buffers_.reserve(16);
+}
+
+AsyncLogging::~AsyncLogging()
+{
+    if (running_) {
+        stop();
+    }
+}
+
+void AsyncLogging::start()
+{
+    running_ = true;
+    thread_.start();
+}
+
+void AsyncLogging::stop()
+{
+    {
+        // 在锁内修改，append看到running_为false之后就不会再往缓冲区里写
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+// 前端只在锁内做memcpy，缓冲区不够时才new一块新的，不会等待后端写文件
+// 没有start或者已经stop时没有后端线程回收缓冲区，日志直接写到stderr
+void AsyncLogging::append(const char* logline, size_t len)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) {
+        ::fwrite(logline, 1, len, stderr);
+        return;
+    }
+    if (currentBuffer_->avail() > len) {
+        currentBuffer_->append(logline, len);
+    } else {
+        buffers_.push_back(std::move(currentBuffer_));
+
+        if (nextBuffer_) {
+            currentBuffer_ = std::move(nextBuffer_);
+        } else {
+            currentBuffer_.reset(new LogBuffer); // 前端写得太快，两块缓冲区都用完了，很少发生
+        }
+        currentBuffer_->append(logline, len);
+        cond_.notify_one();
+    }
+}
+
+void AsyncLogging::threadFunc()
+{
+    LogFile output(basename_, rollSize_, flushInterval_);
+    // 后端准备两块空闲缓冲区，用于在锁内替换前端的currentBuffer_和nextBuffer_
+    BufferPtr newBuffer1(new LogBuffer);
+    BufferPtr newBuffer2(new LogBuffer);
+    BufferVector buffersToWrite;
+    buffersToWrite.reserve(16);
+
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (buffers_.empty()) {
+                // 没有写满的缓冲区就最多等flushInterval_秒，把不满的当前缓冲区也写出去
+                cond_.wait_for(lock, std::chrono::seconds(flushInterval_));
+            }
+            buffers_.push_back(std::move(currentBuffer_));
+            currentBuffer_ = std::move(newBuffer1);
+            buffersToWrite.swap(buffers_);
+            if (!nextBuffer_) {
+                nextBuffer_ = std::move(newBuffer2);
+            }
+        }
+
+        // 以下都在锁外执行，前端可以继续写日志
+        if (buffersToWrite.size() > kMaxBuffers) {
+            char buf[256];
+            int n = snprintf(buf, sizeof buf, "Dropped log messages at %s, %zd larger buffers\n",
+                Timestamp::now().toString().c_str(), buffersToWrite.size() - 2);
+            fputs(buf, stderr);
+            output.append(buf, n);
+            buffersToWrite.erase(buffersToWrite.begin() + 2, buffersToWrite.end());
+        }
+
+        for (const BufferPtr& buffer : buffersToWrite) {
+            output.append(buffer->data(), buffer->length());
+        }
+
+        // 只保留两块缓冲区用于下一轮替换，其余释放
+        if (buffersToWrite.size() > 2) {
+            buffersToWrite.resize(2);
+        }
+        if (!newBuffer1) {
+            newBuffer1 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer1->reset();
+        }
+        if (!newBuffer2) {
+            newBuffer2 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer2->reset();
+        }
+        buffersToWrite.clear();
+        output.flush();
+    }
+
+    // 退出前把剩下的日志写完
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        buffers_.push_back(std::move(currentBuffer_));
+        buffersToWrite.swap(buffers_);
+        currentBuffer_ = std::move(newBuffer1);
+    }
+    for (const BufferPtr& buffer : buffersToWrite) {
+        output.append(buffer->data(), buffer->length());
+    }
+    output.flush();
+}
@@ -0,0 +1,88 @@
+#ifndef ASYNCLOGGING_H
+#define ASYNCLOGGING_H
+
+#pragma once
+#include "Thread.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+//
+// 异步日志 双缓冲
+// 前端线程调用append只是把日志拷贝到当前4MB缓冲区，写满后换上备用缓冲区，不会等待磁盘IO
+// 后端线程每flushInterval秒或者有缓冲区写满时被唤醒，在锁内与前端交换整组缓冲区，
+// 出锁后再把日志写入滚动文件LogFile，写完的缓冲区回收作为下一轮的备用缓冲区
+//
+// 使用方法
+// AsyncLogging* g_asyncLog = new AsyncLogging("/tmp/server", 500 * 1000 * 1000);
+// void asyncOutput(const char* msg, size_t len) { g_asyncLog->append(msg, len); }
+// g_asyncLog->start();
+// Logger::setOutput(asyncOutput);
+//
+class AsyncLogging : noncopyable {
+public:
+    AsyncLogging(const std::string& basename, off_t rollSize, int flushInterval = 3);
+    ~AsyncLogging();
+
+    // 前端线程写日志，start之前和stop之后直接写到stderr
+    void append(const char* logline, size_t len);
+
+    void start();
+    void stop();
+
+private:
+    // 固定大小的日志缓冲区
+    class LogBuffer : noncopyable {
+    public:
+        static const size_t kSize = 4 * 1024 * 1024; // 4MB
+
+        LogBuffer()
+            : data_(new char[kSize])
+            , len_(0)
+        {
+        }
+
+        const char* data() const { return data_.get(); }
+        size_t length() const { return len_; }
+        size_t avail() const { return kSize - len_; }
+        void append(const char* buf, size_t len)
+        {
+            ::memcpy(data_.get() + len_, buf, len);
+            len_ += len;
+        }
+        void reset() { len_ = 0; }
+
+    private:
+        std::unique_ptr<char[]> data_;
+        size_t len_;
+    };
+
+    using BufferPtr = std::unique_ptr<LogBuffer>;
+    using BufferVector = std::vector<BufferPtr>;
+
+    // 后端线程堆积的缓冲区超过kMaxBuffers时丢弃多余的日志，防止日志太多把内存撑爆
+    static const size_t kMaxBuffers = 25;
+
+    void threadFunc();
+
+    const int flushInterval_;
+    const std::string basename_;
+    const off_t rollSize_;
+    std::atomic_bool running_;
+    Thread thread_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    BufferPtr currentBuffer_; // 前端正在写的缓冲区
+    BufferPtr nextBuffer_; // 前端的备用缓冲区
+    BufferVector buffers_; // 已经写满等待后端写入文件的缓冲区
+};
+
+#endif
@@ -1,14 +1,14 @@
 #include "Buffer.h"
 
 #include <cerrno>
+#include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
-const char Buffer::kCRLF[] = "\r\n";
-
 const size_t Buffer::kCheapPrepend; // 一次准备读取字节数可以写在头部
 const size_t Buffer::kInitialSize; // 缓冲区大小
+const size_t Buffer::kMaxReadAhead;
 
 // 从fd中读取数据 Poller工作在LT模式，能保证数据读完
 // Buffer缓冲区有大小，但是从fd上读取数据时并不知道TCP数据最终的大小
@@ -17,6 +17,18 @@ ssize_t Buffer::readFd(int fd, int* savedErrno)
 {
     char extrabuf[65536]; // 栈上内存空间，64K
 
+    if (adaptiveRead_) {
+        // 按这个连接以往的读取量预留空间，大块传输时按内核中实际可读的字节数预留
+        size_t expected = readAheadSize();
+        if (probeAvailable_) {
+            int available = 0;
+            if (::ioctl(fd, FIONREAD, &available) == 0 && available > 0) {
+                expected = std::max(expected, std::min(static_cast<size_t>(available), kMaxReadAhead));
+            }
+        }
+        ensureWritableBytes(expected);
+    }
+
     struct iovec vec[2];
 
     const size_t writable = writableBytes(); // writable是Buffer缓冲区剩余可写空间大小
@@ -31,13 +43,24 @@ ssize_t Buffer::readFd(int fd, int* savedErrno)
     const ssize_t n = ::readv(fd, vec, iovcnt);
     if (n < 0) {
         *savedErrno = errno; // 保存错误号
-    } else if (n <= writable) { // Buffer缓冲区就够用
+        return n;
+    }
+
+    if (static_cast<size_t>(n) <= writable) { // Buffer缓冲区就够用
         writeIndex_ += n;
     } else { // extrabuf中也有数据，说明Buffer缓冲区满了
         writeIndex_ = buffer_.size();
+        copiedBytes_ += n - writable;
         append(extrabuf, n - writable); // 从缓冲区末尾写n-writable大小的数据，需要扩容
     }
 
+    receivedBytes_ += n;
+    if (n > 0) {
+        // EWMA，新的一次读取占1/4的权重
+        size_t readSize = static_cast<size_t>(n);
+        readSizeEstimate_ = readSizeEstimate_ == 0 ? readSize : (readSizeEstimate_ * 3 + readSize) / 4;
+        probeAvailable_ = readSize >= writable;
+    }
     return n;
 }
 
@@ -49,4 +72,44 @@ ssize_t Buffer::writeFd(int fd, int* savedErrno)
         *savedErrno = errno;
     }
     return n;
-}
\ No newline at end of file
+}
+
+// 收缩容量 把可读数据拷贝到一块刚好够用的新内存中，vector的shrink_to_fit不保证释放
+size_t Buffer::shrink(size_t reserve)
+{
+    size_t oldCapacity = buffer_.capacity();
+    size_t readable = readableBytes();
+    std::vector<char> storage(kCheapPrepend + readable + reserve);
+    std::copy(peek(), peek() + readable, storage.begin() + kCheapPrepend);
+    buffer_.swap(storage);
+    readerIndex_ = kCheapPrepend;
+    writeIndex_ = kCheapPrepend + readable;
+
+    size_t reclaimed = oldCapacity > buffer_.capacity() ? oldCapacity - buffer_.capacity() : 0;
+    ++shrinks_;
+    reclaimedBytes_ += reclaimed;
+    return reclaimed;
+}
+
+size_t Buffer::maybeShrink()
+{
+    // 不收缩到自适应读取需要预留的空间以下，否则下一次读取又要扩容
+    size_t threshold = std::max(shrinkThreshold_, kCheapPrepend + readAheadSize());
+    if (shrinkThreshold_ == 0 || buffer_.capacity() <= threshold) {
+        lowReads_ = 0;
+        return 0;
+    }
+
+    size_t readable = readableBytes();
+    if (readable > shrinkLowWaterMark_) {
+        lowReads_ = 0; // 还有较多数据没处理，重新计数
+        return 0;
+    }
+    if (++lowReads_ < shrinkAfterReads_) {
+        return 0;
+    }
+
+    lowReads_ = 0;
+    size_t used = kCheapPrepend + readable;
+    return shrink(threshold > used ? threshold - used : 0);
+}
@@ -2,6 +2,7 @@
 #define BUFFER_H
 
 #include "StringPiece.h.h"
+#include "StringSearch.h"
 #pragma once
 #include <algorithm>
 #include <cstddef>
@@ -24,17 +25,31 @@ class Buffer {
 public:
     static const size_t kCheapPrepend = 8; // 一次准备读取字节数可以写在头部
     static const size_t kInitialSize = 1024; // 缓冲区大小
+    static const size_t kMaxReadAhead = 256 * 1024; // readFd预留可写空间的上限
 
+    // initialSize为0时不分配内存，第一次写入时再分配
     explicit Buffer(size_t initialSize = kInitialSize)
-        : buffer_(kCheapPrepend + initialSize)
+        : buffer_(initialSize > 0 ? kCheapPrepend + initialSize : 0)
         , readerIndex_(kCheapPrepend)
         , writeIndex_(kCheapPrepend)
+        , shrinkThreshold_(0)
+        , shrinkLowWaterMark_(0)
+        , shrinkAfterReads_(0)
+        , lowReads_(0)
+        , shrinks_(0)
+        , reclaimedBytes_(0)
+        , adaptiveRead_(true)
+        , probeAvailable_(true)
+        , readSizeEstimate_(0)
+        , receivedBytes_(0)
+        , copiedBytes_(0)
     {
     }
 
     size_t readableBytes() const { return writeIndex_ - readerIndex_; }
 
-    size_t writableBytes() const { return buffer_.size() - writeIndex_; }
+    // releaseStorage之后buffer_为空，writeIndex_仍是kCheapPrepend
+    size_t writableBytes() const { return buffer_.size() > writeIndex_ ? buffer_.size() - writeIndex_ : 0; }
 
     size_t prependableBytes() const { return readerIndex_; }
 
@@ -94,6 +109,9 @@ public:
     // 并且把readerIndex_往前移动，使得readable区域连起来
     void prepend(const void* data, size_t len)
     {
+        if (buffer_.empty()) {
+            makeSpace(0);
+        }
         readerIndex_ -= len;
         const char* d = static_cast<const char*>(data);
         std::copy(d, d + len, begin() + readerIndex_);
@@ -108,45 +126,121 @@ public:
         return begin() + writeIndex_;
     }
 
+    // 缓冲区是否持有内存，releaseStorage之后为false，下次写入时重新分配
+    bool hasStorage() const { return !buffer_.empty(); }
+    size_t internalCapacity() const { return buffer_.capacity(); }
+
+    // 接管storage作为缓冲区的内存，缓冲区中不能有未读数据，用于从BufferPool借内存
+    void adoptStorage(std::vector<char>&& storage)
+    {
+        buffer_.swap(storage);
+        readerIndex_ = kCheapPrepend;
+        writeIndex_ = kCheapPrepend;
+    }
+    // 交出缓冲区的内存，缓冲区中不能有未读数据，之后缓冲区不持有任何内存，用于把内存还给BufferPool
+    std::vector<char> releaseStorage()
+    {
+        std::vector<char> storage;
+        storage.swap(buffer_);
+        readerIndex_ = kCheapPrepend;
+        writeIndex_ = kCheapPrepend;
+        return storage;
+    }
+
+    // 收缩容量到可读数据 + reserve字节，返回释放的字节数
+    size_t shrink(size_t reserve);
+
+    // 收缩策略 容量超过threshold，并且连续reads次maybeShrink时可读数据都不超过lowWaterMark，
+    // 把容量缩回threshold，避免一次大数据让缓冲区一直占着大块内存，threshold为0表示不收缩(默认)
+    // 要求连续多次是为了经常收到大块数据的连接不会反复收缩又扩容
+    void setShrinkPolicy(size_t threshold, size_t lowWaterMark, int reads)
+    {
+        shrinkThreshold_ = threshold;
+        shrinkLowWaterMark_ = std::min(lowWaterMark, threshold);
+        shrinkAfterReads_ = reads;
+        lowReads_ = 0;
+    }
+    // 每次读取并处理完数据之后调用，满足收缩策略时收缩，返回释放的字节数
+    size_t maybeShrink();
+
+    int64_t shrinks() const { return shrinks_; } // 收缩次数
+    int64_t reclaimedBytes() const { return reclaimedBytes_; } // 收缩释放的总字节数
+
     // 从fd中读取数据
     ssize_t readFd(int fd, int* savedErrno);
+
+    // 自适应读取 readFd用EWMA估计这个连接每次读取的字节数，读之前预留好可写空间，
+    // 上一次读取填满了可写空间时(大块传输)再用FIONREAD查询内核接收缓冲区中的字节数，
+    // 让数据直接读进Buffer，而不是先读进栈上的extrabuf再扩容拷贝，默认开启
+    void setAdaptiveRead(bool on) { adaptiveRead_ = on; }
+    // 下一次readFd预计需要的可写空间
+    size_t readAheadSize() const
+    {
+        return adaptiveRead_ ? std::min(readSizeEstimate_ + readSizeEstimate_ / 4, kMaxReadAhead) : 0;
+    }
+
+    int64_t receivedBytes() const { return receivedBytes_; } // readFd读取的总字节数
+    // 读取过程中额外拷贝的字节数，包括从extrabuf拷回Buffer的字节，以及扩容、整理空间时搬移的未读数据
+    int64_t copiedBytes() const { return copiedBytes_; }
     // 通过fd发送数据
     ssize_t writeFd(int fd, int* savedErrno);
 
-    // 从readable区域开始查找\r\n
+    // 从readable区域开始查找\r\n，使用SIMD实现，见StringSearch
     const char* findCRLF() const
     {
-        const char* crlf = std::search(peek(), beginWrite(), kCRLF, kCRLF + 2);
-        return crlf == beginWrite() ? nullptr : crlf;
+        return StringSearch::findCRLF(peek(), beginWrite());
     }
     // 从start始查找\r\n
     const char* findCRLF(const char* start) const
     {
-        const char* crlf = std::search(start, beginWrite(), kCRLF, kCRLF + 2);
-        return crlf == beginWrite() ? nullptr : crlf;
+        return StringSearch::findCRLF(start, beginWrite());
+    }
+    // 查找\n
+    const char* findEOL() const
+    {
+        return StringSearch::findEOL(peek(), beginWrite());
+    }
+    const char* findEOL(const char* start) const
+    {
+        return StringSearch::findEOL(start, beginWrite());
+    }
+    // 查找\r\n\r\n，HTTP请求头的结尾
+    const char* findDoubleCRLF() const
+    {
+        return StringSearch::findDoubleCRLF(peek(), beginWrite());
     }
 
 private:
     // 返回buffer_的首地址
     char* begin()
     {
-        return &*buffer_.begin(); // 先对iterator解引用再取地址
+        return buffer_.data(); // releaseStorage之后buffer_为空，不能对begin()解引用
     }
     const char* begin() const
     {
-        return &*buffer_.begin();
+        return buffer_.data();
     }
 
     // vector扩容函数
     void makeSpace(size_t len)
     {
+        if (buffer_.empty()) { // releaseStorage交出了内存，重新分配
+            buffer_.resize(kCheapPrepend + std::max(len, kInitialSize));
+            readerIndex_ = kCheapPrepend;
+            writeIndex_ = kCheapPrepend;
+            return;
+        }
         // prependableBytes返回readerIndex_，如果读取一部分数据，reader缓冲区能空出一部分空间写数据
         // writer缓冲区+空出的reader缓冲区不足以写数据就需要扩容
         if (writableBytes() + prependableBytes() < len + kCheapPrepend) {
+            if (writeIndex_ + len > buffer_.capacity()) {
+                copiedBytes_ += readableBytes(); // vector重新分配内存，搬移已有数据
+            }
             buffer_.resize(writeIndex_ + len);
         } else {
             // 如果空间够，把未读的数据拷贝到读缓冲区头部，将已读空间和writer缓冲区连起来
             size_t readable = readableBytes();
+            copiedBytes_ += readable;
             std::copy(begin() + readerIndex_,
                 begin() + writeIndex_,
                 begin() + kCheapPrepend);
@@ -159,7 +253,18 @@ private:
     size_t readerIndex_;
     size_t writeIndex_;
 
-    static const char kCRLF[]; // /r/n标识
+    size_t shrinkThreshold_;
+    size_t shrinkLowWaterMark_;
+    int shrinkAfterReads_;
+    int lowReads_; // 连续多少次maybeShrink时可读数据不超过shrinkLowWaterMark_
+    int64_t shrinks_;
+    int64_t reclaimedBytes_;
+
+    bool adaptiveRead_;
+    bool probeAvailable_; // 第一次读取或者上一次读取填满了可写空间，下一次读之前查询FIONREAD
+    size_t readSizeEstimate_; // 每次读取字节数的EWMA
+    int64_t receivedBytes_;
+    int64_t copiedBytes_;
 };
 
 #endif
\ No newline at end of file
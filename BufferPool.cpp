@@ -0,0 +1,90 @@
+#include "BufferPool.h"
+
+#include <utility>
+
+const size_t BufferPool::kMinClassSize;
+const size_t BufferPool::kMaxClassSize;
+const size_t BufferPool::kDefaultMaxPooledBytes;
+
+BufferPool::BufferPool(size_t maxPooledBytes)
+    : maxPooledBytes_(maxPooledBytes)
+    , stats_ { 0, 0, 0, 0, 0 }
+{
+}
+
+int BufferPool::classForSize(size_t size)
+{
+    int index = 0;
+    while (index < kNumClasses && classSize(index) < size) {
+        ++index;
+    }
+    return index; // kNumClasses表示超过了最大的size class
+}
+
+std::vector<char> BufferPool::acquire(size_t size)
+{
+    ++stats_.acquired;
+
+    int index = classForSize(size);
+    if (index == kNumClasses) {
+        return std::vector<char>(size);
+    }
+
+    // 对应的size class没有空闲内存时借更大的，扩容过的缓冲区归还到大的size class，
+    // 只从对应的size class借的话这些内存很难被再次借出
+    for (int i = index; i < kNumClasses; ++i) {
+        std::vector<std::vector<char>>& freeList = freeLists_[i];
+        if (!freeList.empty()) {
+            std::vector<char> storage = std::move(freeList.back());
+            freeList.pop_back();
+            stats_.pooledBytes -= storage.capacity();
+            ++stats_.reused;
+            return storage;
+        }
+    }
+    return std::vector<char>(classSize(index));
+}
+
+void BufferPool::release(std::vector<char>&& storage)
+{
+    if (stats_.pooledBytes > maxPooledBytes()) {
+        trim(); // 上限在其他线程被调小了
+    }
+
+    size_t capacity = storage.capacity();
+    if (capacity < kMinClassSize
+        || capacity >= 2 * kMaxClassSize
+        || stats_.pooledBytes + capacity > maxPooledBytes()) {
+        ++stats_.dropped;
+        std::vector<char>().swap(storage); // 直接释放
+        return;
+    }
+
+    // 向下取整到size class，Buffer扩容后的capacity不一定是2的幂
+    int index = kNumClasses - 1;
+    while (classSize(index) > capacity) {
+        --index;
+    }
+    storage.resize(classSize(index)); // 只缩小size，不会重新分配
+    stats_.pooledBytes += capacity;
+    ++stats_.released;
+    freeLists_[index].push_back(std::move(storage));
+}
+
+void BufferPool::setMaxPooledBytes(size_t maxPooledBytes)
+{
+    maxPooledBytes_.store(maxPooledBytes, std::memory_order_relaxed);
+}
+
+void BufferPool::trim()
+{
+    size_t maxBytes = maxPooledBytes();
+    // 先释放大块内存
+    for (int index = kNumClasses - 1; index >= 0 && stats_.pooledBytes > maxBytes; --index) {
+        std::vector<std::vector<char>>& freeList = freeLists_[index];
+        while (!freeList.empty() && stats_.pooledBytes > maxBytes) {
+            stats_.pooledBytes -= freeList.back().capacity();
+            freeList.pop_back();
+        }
+    }
+}
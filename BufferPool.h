@@ -0,0 +1,65 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#pragma once
+#include "noncopyable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// 每个EventLoop一个的缓冲区内存池，按2的幂分为若干size class，每个size class一个空闲链表
+// +------+------+------+-----+--------+
+// |  1K  |  2K  |  4K  | ... |  256K  |
+// +------+------+------+-----+--------+
+// TcpConnection在有数据收发时从池中借出内存，数据处理完、发送完后归还，空闲连接不持有缓冲区内存，
+// 大量空闲连接时省下每个连接固定的缓冲区，突发流量时借还只是链表的push/pop，不经过malloc
+// 池中缓存的总字节数有上限，超过上限或者不属于任何size class的内存直接释放
+// 只能在所属loop线程中借还，不加锁，上限可以在任意线程修改
+//
+class BufferPool : noncopyable {
+public:
+    static const size_t kMinClassSize = 1024;
+    static const size_t kMaxClassSize = 256 * 1024;
+    static const size_t kDefaultMaxPooledBytes = 16 * 1024 * 1024;
+
+    struct Stats {
+        int64_t acquired; // 借出次数
+        int64_t reused; // 借出时命中空闲链表的次数
+        int64_t released; // 归还后放回空闲链表的次数
+        int64_t dropped; // 归还时因为超过上限或者大小不合适直接释放的次数
+        size_t pooledBytes; // 空闲链表中缓存的总字节数
+    };
+
+    explicit BufferPool(size_t maxPooledBytes = kDefaultMaxPooledBytes);
+
+    // 借出一块至少size字节的内存，返回的vector的size()等于所在size class的大小，
+    // 这个size class没有空闲内存时借出更大的size class中的内存
+    // size超过kMaxClassSize时直接分配size字节
+    std::vector<char> acquire(size_t size);
+    // 归还内存，按capacity向下取整到size class放回空闲链表
+    void release(std::vector<char>&& storage);
+
+    void setMaxPooledBytes(size_t maxPooledBytes);
+    size_t maxPooledBytes() const { return maxPooledBytes_.load(std::memory_order_relaxed); }
+
+    Stats stats() const { return stats_; } // 只能在loop线程中读取
+
+private:
+    static const int kNumClasses = 9; // 1K 2K 4K ... 256K
+
+    // 能容纳size字节的最小size class
+    static int classForSize(size_t size);
+    static size_t classSize(int index) { return kMinClassSize << index; }
+
+    // 释放空闲链表中的内存，直到缓存的总字节数不超过上限
+    void trim();
+
+    std::vector<std::vector<char>> freeLists_[kNumClasses];
+    std::atomic<size_t> maxPooledBytes_;
+    Stats stats_;
+};
+
+#endif
@@ -7,8 +7,10 @@
 #include <memory>
 
 class Buffer;
+class InetAddress;
 class TcpConnection;
 class Timestamp;
+class UdpSocket;
 
 // TcpConnection回调
 using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
@@ -17,6 +19,13 @@ using CloseCallback = std::function<void(const TcpConnectionPtr)>;
 using WriteCompleteCallback = std::function<void(const TcpConnectionPtr)>;
 using MessageCallback = std::function<void(const TcpConnectionPtr, Buffer*, Timestamp)>;
 using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr, size_t)>;
+// sendFile的完成回调，ok为false表示连接断开或出错，文件区域没有发送完
+using SendFileCompleteCallback = std::function<void(const TcpConnectionPtr, bool ok)>;
+
+// UdpSocket回调，data只在回调期间有效，一次recvmmsg收到的每个数据报回调一次
+using UdpSocketPtr = std::shared_ptr<UdpSocket>;
+using UdpMessageCallback = std::function<void(const UdpSocketPtr&, const char* data, size_t len,
+    const InetAddress& peer, Timestamp)>;
 
 // 定时器回调
 using TimerCallback = std::function<void()>;
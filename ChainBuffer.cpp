@@ -0,0 +1,290 @@
+#include "ChainBuffer.h"
+#include "BufferPool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <utility>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+const size_t ChainBuffer::kBlockSize;
+const size_t ChainBuffer::kMaxSpareBlocks;
+
+// 拷贝数据追加到缓冲区末尾
+// 小数据拷贝进内存块，大数据一次分配一个string，都不需要搬移已有数据
+void ChainBuffer::append(const char* data, size_t len)
+{
+    if (len > kBlockSize) {
+        append(std::string(data, len));
+        return;
+    }
+
+    while (len > 0) {
+        Segment& seg = writableBlock();
+        size_t n = std::min(len, kBlockSize - seg.size);
+        memcpy(seg.block.data() + seg.size, data, n);
+        seg.size += n;
+        readableBytes_ += n;
+        data += n;
+        len -= n;
+    }
+}
+
+// 接管string的内存，小的string直接拷贝进内存块，减少段数
+void ChainBuffer::append(std::string&& str)
+{
+    if (str.size() <= kBlockSize / 4) {
+        append(str.data(), str.size());
+        return;
+    }
+
+    segments_.emplace_back();
+    Segment& seg = segments_.back();
+    seg.owned = std::move(str);
+    seg.data = seg.owned.data(); // 放入deque之后再取地址，短字符串优化的string移动后地址会变
+    seg.size = seg.owned.size();
+    seg.offset = 0;
+    readableBytes_ += seg.size;
+}
+
+// 引用共享的只读数据，不拷贝
+void ChainBuffer::append(const std::shared_ptr<const std::string>& str, size_t offset, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+
+    segments_.emplace_back();
+    Segment& seg = segments_.back();
+    seg.shared = str;
+    seg.data = str->data() + offset;
+    seg.size = len;
+    seg.offset = 0;
+    readableBytes_ += len;
+}
+
+void ChainBuffer::appendZeroCopy(const std::shared_ptr<const std::string>& str, size_t offset, size_t len)
+{
+    append(str, offset, len);
+    if (len > 0) {
+        segments_.back().zeroCopy = true;
+    }
+}
+
+// 完成通知 TCP按序确认数据，通知的序号也是递增的，多次通知可能被内核合并成一个区间
+void ChainBuffer::completeZeroCopy(uint32_t lo, uint32_t hi, bool copied)
+{
+    zeroCopyStats_.completions += hi - lo + 1;
+    if (copied) {
+        zeroCopyStats_.copied += hi - lo + 1;
+    }
+
+    auto it = zeroCopyPinned_.begin();
+    // 序号是32位递增的，用差值比较处理回绕
+    while (it != zeroCopyPinned_.end() && static_cast<int32_t>(it->seq - hi) <= 0) {
+        zeroCopyPinnedBytes_ -= it->size;
+        ++it;
+    }
+    zeroCopyPinned_.erase(zeroCopyPinned_.begin(), it);
+    completedZeroCopySeq_ = hi + 1;
+}
+
+// 追加文件区域，发送时才从文件读取
+void ChainBuffer::appendFile(int fd, off_t offset, size_t len, FileDoneCallback done)
+{
+    segments_.emplace_back();
+    Segment& seg = segments_.back();
+    seg.data = nullptr;
+    seg.size = len;
+    seg.offset = 0;
+    seg.fileFd = fd;
+    seg.fileOffset = offset;
+    seg.done = std::move(done);
+    readableBytes_ += len;
+
+    if (len == 0) {
+        // 空区域不会被writeFd发送，直接完成
+        FileDoneCallback cb(std::move(seg.done));
+        segments_.pop_back();
+        if (cb) {
+            cb(true);
+        }
+    }
+}
+
+// 丢弃前len字节已发送的数据，发送完的段从链表中删除，内存块放回缓存
+void ChainBuffer::retrieve(size_t len)
+{
+    len = std::min(len, readableBytes_);
+    readableBytes_ -= len;
+
+    while (len > 0) {
+        Segment& seg = segments_.front();
+        size_t n = std::min(len, seg.size - seg.offset);
+        seg.offset += n;
+        len -= n;
+
+        if (seg.offset == seg.size) {
+            if (!seg.block.empty()) {
+                recycleBlock(std::move(seg.block));
+            }
+            // 部分发送之后退化为拷贝的段，最后一次MSG_ZEROCOPY的完成通知可能已经先到了
+            if (seg.zeroCopySent && static_cast<int32_t>(seg.zeroCopySeq - completedZeroCopySeq_) >= 0) {
+                // 内核可能还在引用这段内存，等完成通知再释放
+                zeroCopyPinned_.push_back(PinnedZeroCopy { seg.zeroCopySeq, seg.size, std::move(seg.shared) });
+                zeroCopyPinnedBytes_ += seg.size;
+            }
+            FileDoneCallback done(std::move(seg.done));
+            segments_.pop_front();
+            if (done) {
+                done(true); // 文件区域发送完成
+            }
+        }
+    }
+}
+
+void ChainBuffer::retrieveAll()
+{
+    retrieve(readableBytes_);
+}
+
+void ChainBuffer::clear()
+{
+    std::deque<Segment> segments;
+    segments.swap(segments_);
+    readableBytes_ = 0;
+
+    // 内核持有页面的引用只能保证物理页不被回收，没有确认的数据还可能从这些页面发送或者重传，
+    // 如果释放后内存被重新分配，对端会收到不同的内容，所以MSG_ZEROCOPY发送过的string不在这里释放，
+    // 由TcpConnection在析构时先用SO_LINGER{1,0}关闭socket丢弃发送队列，再随ChainBuffer一起释放
+    for (Segment& seg : segments) {
+        if (seg.zeroCopySent && static_cast<int32_t>(seg.zeroCopySeq - completedZeroCopySeq_) >= 0) {
+            zeroCopyPinned_.push_back(PinnedZeroCopy { seg.zeroCopySeq, seg.size, std::move(seg.shared) });
+            zeroCopyPinnedBytes_ += seg.size;
+        }
+    }
+
+    for (Segment& seg : segments) {
+        if (!seg.block.empty()) {
+            recycleBlock(std::move(seg.block));
+        }
+        if (seg.done) {
+            seg.done(false);
+        }
+    }
+}
+
+// 通过fd发送数据 把多段数据组织成iovec数组，一次writev发送
+// 文件区域不能放进iovec，第一段是文件区域时用sendfile单独发送，writev遇到文件区域就停下
+ssize_t ChainBuffer::writeFd(int fd, int* savedErrno)
+{
+    if (!segments_.empty() && segments_.front().fileFd >= 0) {
+        const Segment& seg = segments_.front();
+        off_t offset = seg.fileOffset + static_cast<off_t>(seg.offset);
+        ssize_t n = ::sendfile(fd, seg.fileFd, &offset, seg.size - seg.offset);
+        if (n < 0) {
+            *savedErrno = errno;
+        }
+        return n;
+    }
+
+    if (!segments_.empty() && segments_.front().zeroCopy) {
+        return writeZeroCopy(fd, savedErrno);
+    }
+
+    struct iovec vec[IOV_MAX];
+    int iovcnt = 0;
+
+    for (const Segment& seg : segments_) {
+        if (iovcnt == IOV_MAX || seg.fileFd >= 0 || seg.zeroCopy) {
+            break;
+        }
+        if (seg.size > seg.offset) {
+            vec[iovcnt].iov_base = const_cast<char*>(seg.data + seg.offset);
+            vec[iovcnt].iov_len = seg.size - seg.offset;
+            ++iovcnt;
+        }
+    }
+
+    ssize_t n = ::writev(fd, vec, iovcnt);
+    if (n < 0) {
+        *savedErrno = errno;
+    }
+    return n;
+}
+
+// 最后一段是还有空间的内存块时返回它，否则新加一个内存块
+ChainBuffer::Segment& ChainBuffer::writableBlock()
+{
+    if (!segments_.empty()) {
+        Segment& last = segments_.back();
+        if (!last.block.empty() && last.size < kBlockSize) {
+            return last;
+        }
+    }
+
+    segments_.emplace_back();
+    Segment& seg = segments_.back();
+    if (pool_) {
+        seg.block = pool_->acquire(kBlockSize);
+    } else if (!spareBlocks_.empty()) {
+        seg.block = std::move(spareBlocks_.back());
+        spareBlocks_.pop_back();
+    } else {
+        seg.block.resize(kBlockSize);
+    }
+    seg.data = seg.block.data();
+    seg.size = 0;
+    seg.offset = 0;
+    return seg;
+}
+
+void ChainBuffer::recycleBlock(std::vector<char>&& block)
+{
+    if (pool_) {
+        pool_->release(std::move(block));
+    } else if (spareBlocks_.size() < kMaxSpareBlocks) {
+        spareBlocks_.push_back(std::move(block));
+    }
+}
+
+// MSG_ZEROCOPY每次只发送一段，成功发送后这一段记下内核分配的序号，完成通知覆盖这个序号时才能释放
+ssize_t ChainBuffer::writeZeroCopy(int fd, int* savedErrno)
+{
+    Segment& seg = segments_.front();
+    struct iovec vec;
+    vec.iov_base = const_cast<char*>(seg.data + seg.offset);
+    vec.iov_len = seg.size - seg.offset;
+
+    struct msghdr msg;
+    ::memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &vec;
+    msg.msg_iovlen = 1;
+
+    ssize_t n = ::sendmsg(fd, &msg, MSG_ZEROCOPY);
+    if (n < 0 && errno == ENOBUFS) {
+        // 超过了optmem_max，内核无法再记录更多未完成的发送，这一次退化为普通拷贝
+        n = ::sendmsg(fd, &msg, 0);
+        if (n < 0) {
+            *savedErrno = errno;
+        }
+        return n;
+    }
+    if (n < 0) {
+        *savedErrno = errno;
+        return n;
+    }
+
+    seg.zeroCopySent = true;
+    seg.zeroCopySeq = nextZeroCopySeq_++;
+    ++zeroCopyStats_.sends;
+    zeroCopyStats_.bytes += n;
+    return n;
+}
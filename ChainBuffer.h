@@ -0,0 +1,132 @@
+#ifndef CHAINBUFFER_H
+#define CHAINBUFFER_H
+
+#pragma once
+#include "noncopyable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+class BufferPool;
+
+//
+// +---------+---------+-------------------+---------+
+// | block 0 | block 1 | std::string(大块) | block 2 |
+// +---------+---------+-------------------+---------+
+// ^offset                                      size^
+//
+// 分段的发送缓冲区，由若干段组成，每一段是以下五种之一
+// 1. 固定大小的内存块，小数据拷贝追加到最后一个内存块中
+// 2. 缓冲区自己持有的std::string，大数据一次分配，或者直接接管用户移交的string
+// 3. 多个连接共享的只读string，例如广播消息，不拷贝只增加引用计数
+// 4. 文件的一段区域，发送时用sendfile直接从page cache拷贝到socket，不经过用户态
+// 5. 用MSG_ZEROCOPY发送的共享只读string，内核直接引用string的内存，发送完之后还要等内核的完成通知才能释放
+// 追加数据时不会像Buffer那样resize和搬移已有数据，writeFd用一次writev把多段数据发送出去
+//
+class ChainBuffer : noncopyable {
+public:
+    static const size_t kBlockSize = 4096; // 内存块大小，超过这个大小的数据单独成段
+    static const size_t kMaxSpareBlocks = 2; // 缓存的空闲内存块个数，避免频繁申请释放
+
+    ChainBuffer()
+        : readableBytes_(0)
+        , pool_(nullptr)
+        , zeroCopyPinnedBytes_(0)
+        , nextZeroCopySeq_(0)
+        , completedZeroCopySeq_(0)
+        , zeroCopyStats_ { 0, 0, 0, 0 }
+    {
+    }
+
+    // 设置了pool时内存块从pool借出，发送完立即归还，缓冲区为空时不持有任何内存块
+    // 只能在pool所属的loop线程中操作缓冲区
+    void setPool(BufferPool* pool) { pool_ = pool; }
+
+    size_t readableBytes() const { return readableBytes_; }
+
+    // 拷贝数据追加到缓冲区末尾
+    void append(const char* data, size_t len);
+    // 接管string的内存，不拷贝
+    void append(std::string&& str);
+    // 引用共享的只读数据[offset, offset + len)，不拷贝
+    void append(const std::shared_ptr<const std::string>& str, size_t offset, size_t len);
+    // 与上面相同，但writeFd用MSG_ZEROCOPY发送，socket需要开启SO_ZEROCOPY
+    // 这一段发送完之后str仍然被缓冲区持有，直到completeZeroCopy收到覆盖它的完成通知
+    void appendZeroCopy(const std::shared_ptr<const std::string>& str, size_t offset, size_t len);
+    // socket错误队列中读到的完成通知，序号[lo, hi]的MSG_ZEROCOPY发送已经完成，copied表示内核退化为了拷贝
+    void completeZeroCopy(uint32_t lo, uint32_t hi, bool copied);
+    // 还在等待完成通知的字节数
+    size_t zeroCopyPinnedBytes() const { return zeroCopyPinnedBytes_; }
+
+    struct ZeroCopyStats {
+        int64_t sends; // MSG_ZEROCOPY的send次数
+        int64_t bytes; // MSG_ZEROCOPY发送的字节数
+        int64_t completions; // 收到完成通知的send次数
+        int64_t copied; // 其中内核退化为拷贝的次数，例如发往loopback或者网卡不支持scatter-gather
+    };
+    const ZeroCopyStats& zeroCopyStats() const { return zeroCopyStats_; }
+
+    // 文件区域发送完成或被丢弃时的回调，ok为false表示被clear丢弃
+    using FileDoneCallback = std::function<void(bool ok)>;
+    // 追加文件fd中[offset, offset + len)的区域，缓冲区不负责关闭fd
+    void appendFile(int fd, off_t offset, size_t len, FileDoneCallback done);
+
+    // 丢弃前len字节已发送的数据，发送完的文件区域回调done(true)
+    void retrieve(size_t len);
+    void retrieveAll();
+    // 丢弃所有数据，没发送完的文件区域回调done(false)，MSG_ZEROCOPY发送过、没有收到完成通知的string仍然保留，
+    // 直到收到完成通知或者ChainBuffer析构
+    void clear();
+
+    // 通过fd发送数据，一次writev最多发送IOV_MAX段，第一段是文件区域时用sendfile发送
+    ssize_t writeFd(int fd, int* savedErrno);
+
+private:
+    struct Segment {
+        std::vector<char> block; // 内存块
+        std::string owned; // 缓冲区持有的string
+        std::shared_ptr<const std::string> shared; // 共享的只读string
+        const char* data; // 这一段数据的起始地址
+        size_t size; // 这一段已写入的字节数
+        size_t offset; // 这一段已发送的字节数
+        int fileFd = -1; // 文件区域的fd，内存段为-1
+        off_t fileOffset = 0; // 文件区域在文件中的起始偏移
+        FileDoneCallback done;
+        bool zeroCopy = false; // 用MSG_ZEROCOPY发送
+        bool zeroCopySent = false; // 至少有一次MSG_ZEROCOPY发送成功
+        uint32_t zeroCopySeq = 0; // 这一段最后一次MSG_ZEROCOPY发送的序号
+    };
+
+    // 发送完、等待完成通知的MSG_ZEROCOPY数据
+    struct PinnedZeroCopy {
+        uint32_t seq;
+        size_t size;
+        std::shared_ptr<const std::string> data;
+    };
+
+    // 最后一段是还有空间的内存块时返回它，否则新加一个内存块
+    Segment& writableBlock();
+    // 发送完或者被丢弃的内存块还给pool_或者放进spareBlocks_
+    void recycleBlock(std::vector<char>&& block);
+    // 用MSG_ZEROCOPY发送第一段
+    ssize_t writeZeroCopy(int fd, int* savedErrno);
+
+    std::deque<Segment> segments_; // deque在两端增删元素不会移动其他元素，Segment::data不会失效
+    std::vector<std::vector<char>> spareBlocks_; // 没有设置pool_时自己缓存的空闲内存块
+    size_t readableBytes_;
+    BufferPool* pool_;
+
+    std::vector<PinnedZeroCopy> zeroCopyPinned_; // 按序号递增排列，通常只有几项，不用deque避免空闲连接也占内存
+    size_t zeroCopyPinnedBytes_;
+    uint32_t nextZeroCopySeq_; // 内核给每次成功的MSG_ZEROCOPY发送分配的序号，从0开始递增
+    uint32_t completedZeroCopySeq_; // 小于它的序号都已经收到完成通知
+    ZeroCopyStats zeroCopyStats_;
+};
+
+#endif
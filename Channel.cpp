@@ -8,6 +8,7 @@
 const int Channel::kNoneEvent = 0;
 const int Channel::kReadEvent = EPOLLIN | EPOLLPRI; // 文件描述符可读 | 有tcp紧急的数据可读
 const int Channel::kWriteEvent = EPOLLOUT;
+const int Channel::kEdgeTriggered = EPOLLET;
 
 // 构造函数初始化
 Channel::Channel(EventLoop* loop, int fd)
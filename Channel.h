@@ -68,11 +68,18 @@ public:
         events_ = kNoneEvent;
         update();
     }
+    // 边沿触发模式，同时注册读写事件，之后写事件不再随outputBuffer_开关，读写都要进行到EAGAIN为止
+    void enableReadWriteEdgeTriggered()
+    {
+        events_ |= kReadEvent | kWriteEvent | kEdgeTriggered;
+        update();
+    }
 
     // 返回fd当前的事件状态
     bool isNoneEvent() const { return events_ == kNoneEvent; }
     bool isReading() const { return events_ & kReadEvent; }
     bool isWriting() const { return events_ & kWriteEvent; }
+    bool isEdgeTriggered() const { return events_ & kEdgeTriggered; }
 
     int index() { return index_; }
     void set_index(int idx) { index_ = idx; }
@@ -88,6 +95,7 @@ private:
     static const int kNoneEvent;
     static const int kReadEvent;
     static const int kWriteEvent;
+    static const int kEdgeTriggered;
 
     EventLoop* loop_; // 事件循环
     const int fd_; // socketfd, Poller监听的对象
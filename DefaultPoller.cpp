@@ -1,15 +1,32 @@
 #include "Poller.h"
 #include "EPollPoller.h"
+#ifdef MYMUDUO_EXPERIMENTAL_IOURING
+#include "IoUringPoller.h"
+#endif
+#include "Logger.h"
 
 #include <cstdlib>
 
 // 这个函数是虚基类的静态方法，需要引用子类的头文件，所以不放在Poller.cpp中实现
 // EventLoop通过这个接口获取默认的IO复用的实例
+// 设置环境变量MUDUO_USE_IOURING时使用实验性的io_uring，没有用MYMUDUO_EXPERIMENTAL_IOURING编译或者内核不支持时回退到epoll
 Poller* Poller::newDefaultPoller(EventLoop* loop)
 {
     if (::getenv("MUDUO_USE_POLL")) {
         return nullptr; // 生成poll的实例
+    } else if (::getenv("MUDUO_USE_IOURING")) {
+#ifdef MYMUDUO_EXPERIMENTAL_IOURING
+        IoUringPoller* poller = new IoUringPoller(loop);
+        if (poller->valid()) {
+            return poller; // 生成io_uring的实例
+        }
+        LOG_ERROR("io_uring is not available, fall back to epoll\n");
+        delete poller;
+#else
+        LOG_ERROR("built without MYMUDUO_EXPERIMENTAL_IOURING, fall back to epoll\n");
+#endif
+        return new EPollPoller(loop);
     } else {
         return new EPollPoller(loop); // 生成epoll的实例
     }
-}
\ No newline at end of file
+}
@@ -25,6 +25,7 @@ public:
     Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
     void updateChannel(Channel* channel) override;
     void removeChannel(Channel* channel) override;
+    bool supportsEdgeTriggered() const override { return true; }
 
 private:
     static const int kInitEventListSize = 16;
@@ -1,4 +1,5 @@
 #include "EventLoop.h"
+#include "BufferPool.h"
 #include "Channel.h"
 #include "CurrentThread.h"
 #include "Logger.h"
@@ -9,7 +10,6 @@
 #include <cerrno>
 #include <cstdint>
 #include <functional>
-#include <mutex>
 #include <sys/eventfd.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -35,12 +35,16 @@ int createEventfd()
 EventLoop::EventLoop()
     : looping_(false)
     , quit_(false)
-    , callingPendingFunctors_(false)
     , threadId_(CurrentThread::tid())
     , poller_(Poller::newDefaultPoller(this))
     , timerQueue_(new TimerQueue(this))
     , wakeupFd_(createEventfd())
     , wakeupChannel_(new Channel(this, wakeupFd_)) // 相当于每个EventLoop都监听自己的wakeupFd_
+    , wakeupPending_(false)
+    , connectionCount_(0)
+    , pendingBytes_(0)
+    , reclaimedBufferBytes_(0)
+    , bufferPool_(new BufferPool())
 {
     LOG_DEBUG("EventLoop created %p in thread %d\n", this, threadId_);
     if (t_loopInThisThread) {
@@ -62,6 +66,11 @@ EventLoop::~EventLoop()
     wakeupChannel_->remove();
     ::close(wakeupFd_);
     t_loopInThisThread = nullptr;
+
+    // 释放没来得及执行的回调
+    while (MpscNode* node = pendingFunctors_.pop()) {
+        delete static_cast<FunctorNode*>(node);
+    }
 }
 
 // wakeup的唤醒回调函数
@@ -87,6 +96,8 @@ void EventLoop::loop()
 
         // poller调用poll将活跃事件保存到activeChannels_中
         pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        // loop已经醒来，处理完事件后会执行doPendingFunctors，这期间其他线程queueInloop不需要唤醒
+        wakeupPending_.store(true);
 
         // 对每个活跃事件进行事件处理
         // 有两类，一类是client的fd，一类是wakeupFd
@@ -132,14 +143,12 @@ void EventLoop::runInloop(Functor cb)
 // 把cb放入队列中，唤醒loop所在线程，执行cb
 void EventLoop::queueInloop(Functor cb)
 {
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        pendingFunctors_.emplace_back(cb); // push_back拷贝构造 emplace_back直接构造
-    }
+    pendingFunctors_.push(new FunctorNode(std::move(cb)));
 
     // 唤醒需要执行上面回调操作的loop线程
-    // callingPendingFunctors_为true时，当前loop正在执行回调，但又有了新的回调，执行完当前回调后会在poll阻塞，需要唤醒
-    if (!isInLoopThread() || callingPendingFunctors_) {
+    // wakeupPending_为true说明loop醒着还没开始执行本轮回调，或者已经有人唤醒过，不需要重复写wakeupFd_
+    // loop正在执行回调时wakeupPending_已经置为false，新的回调需要唤醒，否则执行完当前回调后会在poll阻塞
+    if (!wakeupPending_.exchange(true)) {
         wakeup();
     }
 }
@@ -168,22 +177,27 @@ bool EventLoop::hasChannel(Channel* channel)
     return poller_->hasChannel(channel);
 }
 
+bool EventLoop::supportsEdgeTriggered() const
+{
+    return poller_->supportsEdgeTriggered();
+}
+
 // 处理回调函数
 void EventLoop::doPendingFunctors()
 {
-    std::vector<Functor> functors;
-    callingPendingFunctors_ = true;
+    // 必须先置为false再取回调，否则在取完之后才入队的回调可能既不被执行也不唤醒loop
+    wakeupPending_.store(false);
 
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        functors.swap(pendingFunctors_); // 先交换cb到局部变量并把pendingFunctors_置空，方便高并发时快速存取cb
+    // 先把队列中已有的回调全部取出，本轮执行回调时新加入的回调留到下一轮，由queueInloop负责唤醒
+    while (MpscNode* node = pendingFunctors_.pop()) {
+        runningFunctors_.push_back(static_cast<FunctorNode*>(node));
     }
 
-    for (const Functor& functor : functors) {
-        functor(); // 执行当前loop需要执行的回调
+    for (FunctorNode* node : runningFunctors_) {
+        node->functor(); // 执行当前loop需要执行的回调
+        delete node;
     }
-
-    callingPendingFunctors_ = false;
+    runningFunctors_.clear();
 }
 
 // 定时器操作函数，用于添加定时器任务
@@ -211,4 +225,19 @@ TimerId EventLoop::runEvery(double interval, TimerCallback cb)
 void EventLoop::cancel(TimerId timerId)
 {
     return timerQueue_->cancel(timerId);
-}
\ No newline at end of file
+}
+
+// 粗粒度定时器，delay秒后运行回调
+TimerId EventLoop::runAfterCoarse(double delay, TimerCallback cb)
+{
+    if (!isInLoopThread()) {
+        LOG_FATAL("EventLoop::runAfterCoarse must be called in loop thread %d\n", threadId_);
+    }
+    return timerQueue_->addCoarseTimer(std::move(cb), delay);
+}
+
+// 刷新粗粒度定时器
+void EventLoop::touch(TimerId timerId)
+{
+    timerQueue_->touch(timerId);
+}
@@ -5,16 +5,18 @@
 #include "TimerId.h"
 #pragma once
 #include "CurrentThread.h"
+#include "MpscQueue.h"
 #include "Timestamp.h"
 #include "noncopyable.h"
 
 #include <atomic>
+#include <cstdint>
 #include <ctime>
 #include <functional>
 #include <memory>
-#include <mutex>
 #include <vector>
 
+class BufferPool;
 class Channel;
 class Poller;
 class TimerQueue;
@@ -29,6 +31,8 @@ public:
     void loop(); // 开启事件循环
     void quit(); // 退出事件循环
 
+    // 每轮循环Poller::poll返回时获取一次的时间，相当于loop缓存的当前时间
+    // loop线程中处理事件的热点路径可以用它代替Timestamp::now()，误差为本轮事件处理的耗时
     Timestamp pollReturnTime() const { return pollReturnTime_; }
 
     void runInloop(Functor cb); // 在当前loop中执行cb
@@ -40,6 +44,8 @@ public:
     void updateChannel(Channel* channel);
     void removeChannel(Channel* channel);
     bool hasChannel(Channel* channel);
+    // Poller是否支持EPOLLET，io_uring的一次性POLL_ADD模拟的是LT语义，不支持
+    bool supportsEdgeTriggered() const;
 
     // 判断EventLoop对象是否在自己线程里面
     bool isInLoopThread() const { return threadId_ == CurrentThread::tid(); }
@@ -48,9 +54,36 @@ public:
     TimerId runAt(Timestamp time, TimerCallback cb); // 立即运行回调
     TimerId runAfter(double delay, TimerCallback cb); // delay秒后运行回调
     TimerId runEvery(double interval, TimerCallback cb); // 每隔interval时间后运行回调
-    void cancel(TimerId timerId); // 取消定时器
+    void cancel(TimerId timerId); // 取消定时器，普通定时器和粗粒度定时器都可以取消
+
+    // 粗粒度定时器，保存在时间轮中，精度为100ms，插入、刷新、取消都是O(1)
+    // 适合每个连接一个、每次收到消息都要刷新的空闲超时定时器，只能在loop线程中调用
+    TimerId runAfterCoarse(double delay, TimerCallback cb);
+    void touch(TimerId timerId); // 把粗粒度定时器的到期时间刷新为当前时间 + delay
+
+    // 负载统计，由TcpConnection更新，供EventLoopThreadPool的负载均衡策略在mainloop中读取
+    int connectionCount() const { return connectionCount_.load(std::memory_order_relaxed); }
+    int64_t pendingBytes() const { return pendingBytes_.load(std::memory_order_relaxed); }
+    void addConnectionCount(int delta) { connectionCount_.fetch_add(delta, std::memory_order_relaxed); }
+    void addPendingBytes(int64_t delta) { pendingBytes_.fetch_add(delta, std::memory_order_relaxed); }
+
+    // 属于该loop的连接的inputBuffer_收缩释放的总字节数
+    int64_t reclaimedBufferBytes() const { return reclaimedBufferBytes_.load(std::memory_order_relaxed); }
+    void addReclaimedBufferBytes(int64_t bytes) { reclaimedBufferBytes_.fetch_add(bytes, std::memory_order_relaxed); }
+
+    // 属于该loop的连接共用的缓冲区内存池，只能在loop线程中借还
+    BufferPool* bufferPool() const { return bufferPool_.get(); }
 
 private:
+    // pendingFunctors_队列的节点，每次queueInloop只分配一次
+    struct FunctorNode : MpscNode {
+        explicit FunctorNode(Functor&& f)
+            : functor(std::move(f))
+        {
+        }
+        Functor functor;
+    };
+
     void handleRead(); // waked up
     void doPendingFunctors(); // 处理回调函数
 
@@ -71,9 +104,17 @@ private:
 
     ChannelList activeChannels_;
 
-    std::atomic_bool callingPendingFunctors_; // 标识当前loop是否有需要执行的回调操作
-    std::vector<Functor> pendingFunctors_; // 存储loop需要执行的所有回调操作
-    std::mutex mutex_; // 互斥锁，用于保护vector容器的线程安全操作
+    // 为true时表示loop在阻塞到poll之前一定会检查pendingFunctors_，不需要再写wakeupFd_
+    // loop醒着处理事件，或者已经有人写过wakeupFd_时为true，每轮执行回调前置为false
+    std::atomic_bool wakeupPending_;
+    MpscQueue pendingFunctors_; // 存储loop需要执行的所有回调操作，无锁多生产者单消费者队列
+    std::vector<FunctorNode*> runningFunctors_; // doPendingFunctors中本轮取出的回调
+
+    std::atomic_int connectionCount_; // 属于该loop的存活连接数
+    std::atomic<int64_t> pendingBytes_; // 属于该loop的连接还没发送出去的字节数之和
+    std::atomic<int64_t> reclaimedBufferBytes_;
+
+    std::unique_ptr<BufferPool> bufferPool_;
 };
 
 #endif
\ No newline at end of file
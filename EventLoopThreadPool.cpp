@@ -55,6 +55,17 @@ EventLoop* EventLoopThreadPool::getNextLoop()
     return loop;
 }
 
+EventLoop* EventLoopThreadPool::getLoopForConnection(const InetAddress& peerAddr)
+{
+    if (loops_.empty()) {
+        return baseloop_;
+    }
+    if (!strategy_) {
+        return getNextLoop();
+    }
+    return strategy_->select(loops_, peerAddr);
+}
+
 std::vector<EventLoop*> EventLoopThreadPool::getAllLoops()
 {
     if (loops_.empty()) {
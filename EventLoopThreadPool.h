@@ -2,6 +2,7 @@
 #define EVENTLOOPTHREADPOOL_H
 
 #pragma once
+#include "LoadBalanceStrategy.h"
 #include "noncopyable.h"
 
 #include <functional>
@@ -11,6 +12,7 @@
 
 class EventLoop;
 class EventLoopThread;
+class InetAddress;
 
 class EventLoopThreadPool : noncopyable {
 public:
@@ -24,6 +26,11 @@ public:
 
     // 如果工作在多线程中，baseloop会默认以轮询方式分配Channel给subloop
     EventLoop* getNextLoop();
+    // 按负载均衡策略为peerAddr的新连接选择subloop，没有设置策略时为轮询
+    EventLoop* getLoopForConnection(const InetAddress& peerAddr);
+
+    // 设置负载均衡策略，在mainloop中调用
+    void setStrategy(std::unique_ptr<LoadBalanceStrategy> strategy) { strategy_ = std::move(strategy); }
 
     std::vector<EventLoop*> getAllLoops();
 
@@ -38,6 +45,7 @@ private:
     int next_;
     std::vector<std::unique_ptr<EventLoopThread>> threads_; // 保存所有线程
     std::vector<EventLoop*> loops_; // 保存所有EventLoop指针，通过EventLoopThread的startLoop可以得到
+    std::unique_ptr<LoadBalanceStrategy> strategy_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,355 @@
+#include "IoUringPoller.h"
+#include "Channel.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 状态指示 与EPollPoller含义相同
+const int kNew = -1; // Channel还未添加到Poller中 Channel成员index_=-1
+const int kAdded = 1; // Channel已经添加到Poller中
+const int kDeleted = 2; // Channel已经从Poller中删除
+
+// POLL_REMOVE请求使用的user_data，返回的CQE不对应任何Channel
+const uint64_t kRemoveUserData = 0;
+
+static int ioUringSetup(unsigned entries, struct io_uring_params* p)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int ioUringEnter(int ringfd, unsigned toSubmit, unsigned minComplete,
+    unsigned flags, const void* arg, size_t argSize)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ringfd, toSubmit, minComplete, flags, arg, argSize));
+}
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+    : Poller(loop)
+    , ringfd_(-1)
+    , features_(0)
+    , sqRing_(MAP_FAILED)
+    , sqRingSize_(0)
+    , cqRing_(MAP_FAILED)
+    , cqRingSize_(0)
+    , sqes_(static_cast<struct io_uring_sqe*>(MAP_FAILED))
+    , sqesSize_(0)
+    , toSubmit_(0)
+    , nextSeq_(0)
+{
+    if (!setupRing()) {
+        LOG_ERROR("IoUringPoller::setupRing error: %d\n", errno);
+    }
+}
+
+IoUringPoller::~IoUringPoller()
+{
+    if (sqes_ != MAP_FAILED) {
+        ::munmap(sqes_, sqesSize_);
+    }
+    if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_ != MAP_FAILED) {
+        ::munmap(sqRing_, sqRingSize_);
+    }
+    if (ringfd_ >= 0) {
+        ::close(ringfd_);
+    }
+}
+
+// io_uring_setup创建ring，并把SQ、CQ和SQE数组mmap到用户空间
+bool IoUringPoller::setupRing()
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof params);
+
+    int fd = ioUringSetup(kRingEntries, &params);
+    if (fd < 0) {
+        return false;
+    }
+
+    // poll的超时时间需要通过IORING_ENTER_EXT_ARG传入，5.11以前的内核不支持
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        ::close(fd);
+        errno = ENOSYS;
+        return false;
+    }
+    ringfd_ = fd;
+    features_ = params.features;
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    // 新内核SQ和CQ可以共用一次mmap
+    if (features_ & IORING_FEAT_SINGLE_MMAP) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        return false;
+    }
+
+    if (features_ & IORING_FEAT_SINGLE_MMAP) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            return false;
+        }
+    }
+
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = static_cast<struct io_uring_sqe*>(::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) {
+        return false;
+    }
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    return true;
+}
+
+// 获取一个空闲的SQE
+// 没有开启SQPOLL，内核只在io_uring_enter时读取SQ，所以这里可以先推进tail再填写SQE
+struct io_uring_sqe* IoUringPoller::getSqe()
+{
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    unsigned tail = *sqTail_;
+
+    // SQ已满，先把积攒的SQE提交给内核，内核可能只取走一部分甚至一个都不取，
+    // 要重新读head，直到确实腾出了空间，否则会覆盖还没有提交的SQE
+    while (tail - head >= sqEntries_) {
+        int ret = ioUringEnter(ringfd_, toSubmit_, 0, 0, nullptr, 0);
+        if (ret > 0) {
+            toSubmit_ -= ret;
+        } else if (ret < 0 && errno == EBUSY) {
+            // CQ溢出，内核要等CQ有空位才接收新的SQE，先把CQE取出来暂存，下一次poll时再处理
+            reapCompletions();
+        } else if (ret < 0 && errno != EINTR && errno != EAGAIN) {
+            LOG_FATAL("io_uring_enter submit error: %d\n", errno);
+        }
+        head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    }
+
+    unsigned index = tail & sqMask_;
+    struct io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof *sqe);
+    sqArray_[index] = index;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+    ++toSubmit_;
+    return sqe;
+}
+
+// 给Channel挂上一次性的POLL_ADD请求
+// user_data高32位是序列号，低32位是fd，撤销后旧请求返回的CQE序列号对不上会被丢弃
+void IoUringPoller::arm(Channel* channel)
+{
+    int fd = channel->fd();
+    if (++nextSeq_ == 0) {
+        ++nextSeq_; // 跳过0，保证user_data不会与kRemoveUserData冲突
+    }
+    uint64_t userData = (static_cast<uint64_t>(nextSeq_) << 32) | static_cast<uint32_t>(fd);
+
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = static_cast<uint32_t>(channel->events()); // EPOLLIN等与POLLIN等取值相同
+    sqe->user_data = userData;
+
+    armed_[fd] = userData;
+}
+
+// 撤销fd上已经挂上的POLL_ADD请求
+void IoUringPoller::disarm(int fd)
+{
+    std::unordered_map<int, uint64_t>::iterator it = armed_.find(fd);
+    if (it == armed_.end() || it->second == 0) {
+        return;
+    }
+
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = it->second;
+    sqe->user_data = kRemoveUserData;
+    if (features_ & IORING_FEAT_CQE_SKIP) {
+        sqe->flags |= IOSQE_CQE_SKIP_SUCCESS; // 撤销成功不需要产生CQE
+    }
+
+    it->second = 0;
+}
+
+// Channel update remove -> EvenrLoop updateChannel removeChannel -> Poller updateChannel removeChannel
+void IoUringPoller::updateChannel(Channel* channel)
+{
+    const int index = channel->index();
+    LOG_INFO("func = %s => fd = %d, events= %d, index = %d\n",
+        __FUNCTION__, channel->fd(), channel->events(), channel->index());
+
+    int fd = channel->fd();
+    if (index == kNew || index == kDeleted) {
+        if (index == kNew) {
+            channels_[fd] = channel;
+        }
+
+        channel->set_index(kAdded);
+        arm(channel);
+
+    } else { // index==kAdded 撤销旧的请求，按新的事件重新挂上
+        disarm(fd);
+        if (channel->isNoneEvent()) {
+            channel->set_index(kDeleted);
+        } else {
+            arm(channel);
+        }
+    }
+}
+
+// 从Poller中删除Channel
+void IoUringPoller::removeChannel(Channel* channel)
+{
+    LOG_DEBUG("func = %s => fd = %d\n", __FUNCTION__, channel->fd());
+
+    int fd = channel->fd();
+    channels_.erase(fd);
+
+    if (channel->index() == kAdded) {
+        disarm(fd);
+    }
+    armed_.erase(fd);
+    channel->set_index(kNew);
+}
+
+// 上一轮返回了事件的Channel，如果还在监听，重新挂上POLL_ADD
+void IoUringPoller::rearmPending()
+{
+    for (int fd : rearmFds_) {
+        ChannelMap::iterator it = channels_.find(fd);
+        if (it != channels_.end()
+            && it->second->index() == kAdded
+            && armed_[fd] == 0) {
+            arm(it->second);
+        }
+    }
+    rearmFds_.clear();
+}
+
+// io_uring_enter 提交SQE并等待至少一个CQE
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+    LOG_DEBUG("func = %s => fd total conut: %zu\n", __FUNCTION__, channels_.size());
+
+    rearmPending();
+
+    struct __kernel_timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000 * 1000;
+
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof arg);
+    if (timeoutMs >= 0) {
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+
+    // 已经有暂存的CQE时不等待，立即返回处理
+    int ret = ioUringEnter(ringfd_, toSubmit_, reaped_.empty() ? 1 : 0,
+        IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof arg);
+    int savedErrno = errno;
+    if (ret > 0) {
+        toSubmit_ -= ret; // 返回值是内核取走的SQE个数
+    }
+
+    Timestamp now(Timestamp::now());
+    size_t before = activeChannels->size();
+    fillActiveChannels(activeChannels);
+    size_t numEvents = activeChannels->size() - before;
+
+    if (numEvents > 0) {
+        LOG_INFO("%zu events happened\n", numEvents);
+    } else if (ret < 0 && savedErrno != EINTR && savedErrno != ETIME && savedErrno != EBUSY) {
+        // EBUSY是CQ溢出，上面已经把CQE取出来了，下一轮会重新提交
+        errno = savedErrno;
+        LOG_ERROR("IoUringPoller::poll() error\n");
+    } else {
+        LOG_DEBUG("%s timeout!\n", __FUNCTION__);
+    }
+    return now;
+}
+
+// 把CQ中的CQE全部取出来暂存到reaped_，腾出CQ的空间
+void IoUringPoller::reapCompletions()
+{
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+        const struct io_uring_cqe* cqe = &cqes_[head & cqMask_];
+        reaped_.push_back(Completion { cqe->user_data, cqe->res });
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+// 遍历取出的CQE，把仍然有效的POLL_ADD结果填写到活跃连接中
+// 暂存期间Channel可能已经撤销甚至fd被复用，靠armed_中的user_data判断CQE是否还有效
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels)
+{
+    reapCompletions();
+
+    for (const Completion& completion : reaped_) {
+        uint64_t userData = completion.userData;
+        int res = completion.res;
+
+        if (userData == kRemoveUserData) {
+            // 撤销时请求可能已经完成，ENOENT/EALREADY不是错误
+            if (res < 0 && res != -ENOENT && res != -EALREADY) {
+                LOG_ERROR("io_uring poll remove error: %d\n", -res);
+            }
+            continue;
+        }
+
+        int fd = static_cast<int>(userData & 0xffffffff);
+        std::unordered_map<int, uint64_t>::iterator armed = armed_.find(fd);
+        if (armed == armed_.end() || armed->second != userData) {
+            continue; // 已经撤销的旧请求
+        }
+        armed->second = 0;
+
+        ChannelMap::iterator it = channels_.find(fd);
+        if (res < 0) {
+            // 请求没有挂上，fd上已经没有POLL_ADD，不重新挂上Channel就再也收不到事件
+            // 内核暂时分配不出资源或者请求被取消时直接重新挂上，其他错误当作EPOLLERR交给Channel处理
+            if (res == -ENOMEM || res == -EAGAIN || res == -ECANCELED || res == -EINTR) {
+                rearmFds_.push_back(fd);
+                continue;
+            }
+            LOG_ERROR("io_uring poll fd = %d error: %d\n", fd, -res);
+            res = EPOLLERR;
+        }
+
+        if (it != channels_.end()) {
+            it->second->set_revents(res); // 给Channel设置具体发生的事件
+            activeChannels->push_back(it->second);
+            rearmFds_.push_back(fd); // 一次性请求，下一轮poll时重新挂上
+        }
+    }
+    reaped_.clear();
+}
@@ -0,0 +1,101 @@
+#ifndef IOURINGPOLLER_H
+#define IOURINGPOLLER_H
+
+#pragma once
+#include "Poller.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <unordered_map>
+#include <vector>
+
+class EventLoop;
+class Channel;
+
+//
+// 实验性的io_uring后端，默认不参与编译，cmake -DMYMUDUO_EXPERIMENTAL_IOURING=ON时才编译进库
+// io_uring的使用 不依赖liburing，直接使用io_uring_setup/io_uring_enter系统调用
+// io_uring_setup -- IoUringPoller(EventLoop* loop)
+// updateChannel / removeChannel -- 只往SQ中填写POLL_ADD/POLL_REMOVE请求，不产生系统调用
+// poll -- 一次io_uring_enter同时提交所有积攒的SQE并等待CQE
+//
+// 每个Channel同时只挂一个一次性的POLL_ADD请求，事件返回后在下一次poll时重新挂上，
+// 重新挂上时如果fd仍然就绪会立刻完成，因此与EPollPoller一样是LT语义，
+// Buffer::readFd、TcpConnection::handleWrite等依赖LT的地方不需要修改
+//
+// 只替代了epoll_ctl/epoll_wait，数据的读写仍然是每个事件一次readv/write，并且每个事件都要重新挂一次POLL_ADD，
+// 单核pingpong测试中吞吐比EPollPoller低3%~24%(16KB 1个连接660 vs 502 MiB/s，100个连接922 vs 811 MiB/s)，
+// 只在epoll_ctl调用非常频繁(大量连接反复修改事件)时才可能有收益
+// multishot accept/recv需要把读缓冲区交给内核，数据的所有权从Buffer转到Poller，与Channel的就绪回调模型不兼容，没有实现
+//
+class IoUringPoller : public Poller {
+public:
+    IoUringPoller(EventLoop* loop);
+    ~IoUringPoller() override;
+
+    // io_uring_setup失败或内核不支持需要的特性时返回false，由newDefaultPoller回退到epoll
+    bool valid() const { return ringfd_ >= 0; }
+
+    // 重写基类Poller的虚方法
+    Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+
+private:
+    static const unsigned kRingEntries = 1024;
+
+    bool setupRing();
+
+    // 获取一个空闲的SQE，SQ满了就先把已填写的SQE提交给内核
+    struct io_uring_sqe* getSqe();
+
+    // 给Channel挂上一次性的POLL_ADD请求
+    void arm(Channel* channel);
+    // 撤销fd上已经挂上的POLL_ADD请求
+    void disarm(int fd);
+
+    // 把到期需要重新挂上的Channel重新加入SQ
+    void rearmPending();
+
+    // 把CQ中的CQE取出来暂存，SQ满了提交时遇到CQ溢出(EBUSY)也要调用
+    void reapCompletions();
+    // 遍历CQ，填写活跃的连接
+    void fillActiveChannels(ChannelList* activeChannels);
+
+    int ringfd_;
+    unsigned features_;
+
+    // SQ和CQ的ring通过mmap与内核共享
+    void* sqRing_;
+    size_t sqRingSize_;
+    void* cqRing_;
+    size_t cqRingSize_;
+    struct io_uring_sqe* sqes_;
+    size_t sqesSize_;
+
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned* sqArray_;
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    struct io_uring_cqe* cqes_;
+
+    unsigned toSubmit_; // 已填写还未提交给内核的SQE个数
+    uint32_t nextSeq_; // 生成POLL_ADD请求的user_data，用于区分同一个fd前后两次挂上的请求
+
+    // key是fd，value是当前挂在该fd上的POLL_ADD请求的user_data，0表示没有挂上
+    std::unordered_map<int, uint64_t> armed_;
+    std::vector<int> rearmFds_; // 上一轮返回了事件，需要重新挂上的fd
+
+    struct Completion {
+        uint64_t userData;
+        int res;
+    };
+    std::vector<Completion> reaped_; // 已经从CQ中取出、还没有处理的CQE
+};
+
+#endif
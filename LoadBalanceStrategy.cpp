@@ -0,0 +1,98 @@
+#include "LoadBalanceStrategy.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+
+#include <ctime>
+#include <netinet/in.h>
+
+std::unique_ptr<LoadBalanceStrategy> LoadBalanceStrategy::newStrategy(Type type)
+{
+    switch (type) {
+    case kLeastConnections:
+        return std::unique_ptr<LoadBalanceStrategy>(new LeastConnectionsStrategy);
+    case kLeastPendingBytes:
+        return std::unique_ptr<LoadBalanceStrategy>(new LeastPendingBytesStrategy);
+    case kPowerOfTwoChoices:
+        return std::unique_ptr<LoadBalanceStrategy>(new PowerOfTwoChoicesStrategy);
+    case kPeerHash:
+        return std::unique_ptr<LoadBalanceStrategy>(new PeerHashStrategy);
+    case kRoundRobin:
+    default:
+        return std::unique_ptr<LoadBalanceStrategy>(new RoundRobinStrategy);
+    }
+}
+
+EventLoop* RoundRobinStrategy::select(const std::vector<EventLoop*>& loops, const InetAddress&)
+{
+    if (next_ >= loops.size()) {
+        next_ = 0;
+    }
+    return loops[next_++];
+}
+
+EventLoop* LeastConnectionsStrategy::select(const std::vector<EventLoop*>& loops, const InetAddress&)
+{
+    size_t n = loops.size();
+    size_t best = next_ % n;
+    int bestCount = loops[best]->connectionCount();
+    for (size_t i = 1; i < n; ++i) {
+        size_t idx = (next_ + i) % n;
+        int count = loops[idx]->connectionCount();
+        if (count < bestCount) {
+            best = idx;
+            bestCount = count;
+        }
+    }
+    next_ = best + 1;
+    return loops[best];
+}
+
+EventLoop* LeastPendingBytesStrategy::select(const std::vector<EventLoop*>& loops, const InetAddress&)
+{
+    size_t n = loops.size();
+    size_t best = next_ % n;
+    int64_t bestBytes = loops[best]->pendingBytes();
+    int bestCount = loops[best]->connectionCount();
+    for (size_t i = 1; i < n; ++i) {
+        size_t idx = (next_ + i) % n;
+        int64_t bytes = loops[idx]->pendingBytes();
+        int count = loops[idx]->connectionCount();
+        if (bytes < bestBytes || (bytes == bestBytes && count < bestCount)) {
+            best = idx;
+            bestBytes = bytes;
+            bestCount = count;
+        }
+    }
+    next_ = best + 1;
+    return loops[best];
+}
+
+PowerOfTwoChoicesStrategy::PowerOfTwoChoicesStrategy()
+    : seed_(static_cast<uint64_t>(::time(nullptr)) * 2654435761u + 1)
+{
+}
+
+EventLoop* PowerOfTwoChoicesStrategy::select(const std::vector<EventLoop*>& loops, const InetAddress&)
+{
+    size_t n = loops.size();
+    if (n == 1) {
+        return loops[0];
+    }
+
+    // xorshift64
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 7;
+    seed_ ^= seed_ << 17;
+    size_t a = seed_ % n;
+    size_t b = (a + 1 + (seed_ >> 32) % (n - 1)) % n; // 保证与a不同
+
+    return loops[a]->connectionCount() <= loops[b]->connectionCount() ? loops[a] : loops[b];
+}
+
+EventLoop* PeerHashStrategy::select(const std::vector<EventLoop*>& loops, const InetAddress& peerAddr)
+{
+    // 只对IP哈希，不包括端口，同一客户端的多个连接分到同一个loop
+    uint32_t ip = ntohl(peerAddr.getSockAddr()->sin_addr.s_addr);
+    uint32_t hash = ip * 2654435761u; // Knuth乘法哈希，打散连续的IP
+    return loops[(hash >> 16) % loops.size()];
+}
@@ -0,0 +1,88 @@
+#ifndef LOADBALANCESTRATEGY_H
+#define LOADBALANCESTRATEGY_H
+
+#pragma once
+#include "noncopyable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class EventLoop;
+class InetAddress;
+
+//
+// 新连接分配subloop的负载均衡策略，只在mainloop中调用，实现可以保存自己的状态
+// 负载数据来自EventLoop::connectionCount和EventLoop::pendingBytes
+//
+class LoadBalanceStrategy : noncopyable {
+public:
+    enum Type {
+        kRoundRobin, // 轮询，原来的默认方式
+        kLeastConnections, // 存活连接数最少的loop
+        kLeastPendingBytes, // 待发送字节数最少的loop，相同时比较连接数
+        kPowerOfTwoChoices, // 随机取两个loop，选连接数少的一个，开销与轮询相当
+        kPeerHash, // 按对端IP哈希，同一个客户端总是分配到同一个loop
+    };
+
+    virtual ~LoadBalanceStrategy() = default;
+
+    // loops不为空
+    virtual EventLoop* select(const std::vector<EventLoop*>& loops, const InetAddress& peerAddr) = 0;
+
+    // 创建内置的策略
+    static std::unique_ptr<LoadBalanceStrategy> newStrategy(Type type);
+};
+
+class RoundRobinStrategy : public LoadBalanceStrategy {
+public:
+    RoundRobinStrategy()
+        : next_(0)
+    {
+    }
+    EventLoop* select(const std::vector<EventLoop*>& loops, const InetAddress& peerAddr) override;
+
+private:
+    size_t next_;
+};
+
+class LeastConnectionsStrategy : public LoadBalanceStrategy {
+public:
+    LeastConnectionsStrategy()
+        : next_(0)
+    {
+    }
+    EventLoop* select(const std::vector<EventLoop*>& loops, const InetAddress& peerAddr) override;
+
+private:
+    size_t next_; // 负载相同时从上次选中的下一个开始比较，避免总是集中在第一个loop
+};
+
+class LeastPendingBytesStrategy : public LoadBalanceStrategy {
+public:
+    LeastPendingBytesStrategy()
+        : next_(0)
+    {
+    }
+    EventLoop* select(const std::vector<EventLoop*>& loops, const InetAddress& peerAddr) override;
+
+private:
+    size_t next_;
+};
+
+class PowerOfTwoChoicesStrategy : public LoadBalanceStrategy {
+public:
+    PowerOfTwoChoicesStrategy();
+    EventLoop* select(const std::vector<EventLoop*>& loops, const InetAddress& peerAddr) override;
+
+private:
+    uint64_t seed_; // xorshift随机数状态
+};
+
+class PeerHashStrategy : public LoadBalanceStrategy {
+public:
+    EventLoop* select(const std::vector<EventLoop*>& loops, const InetAddress& peerAddr) override;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef LOGFILE_H
+#define LOGFILE_H
+
+#pragma once
+#include "noncopyable.h"
+
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <sys/types.h>
+
+//
+// 滚动日志文件，只在AsyncLogging的后台线程中使用，不加锁
+// 文件名格式 basename.20231016-213015.hostname.pid.log
+// 写满rollSize字节或者跨天时切换到新文件
+// 每写checkEveryN次检查一次是否跨天以及是否需要fflush，避免每次append都调用time
+//
+class LogFile : noncopyable {
+public:
+    LogFile(const std::string& basename,
+        off_t rollSize,
+        int flushInterval = 3,
+        int checkEveryN = 1024);
+    ~LogFile();
+
+    void append(const char* logline, size_t len);
+    void flush();
+    bool rollFile();
+
+private:
+    static std::string getLogFileName(const std::string& basename, time_t* now);
+
+    const std::string basename_;
+    const off_t rollSize_; // 单个文件的最大字节数
+    const int flushInterval_; // 两次fflush的最大间隔，单位秒
+    const int checkEveryN_;
+
+    int count_; // 距离上次检查已经append的次数
+    time_t startOfPeriod_; // 当前文件所在那一天的零点(UTC)
+    time_t lastRoll_;
+    time_t lastFlush_;
+
+    FILE* fp_;
+    off_t writtenBytes_; // 当前文件已写入的字节数
+    char buffer_[64 * 1024]; // fp_的用户态缓冲区
+
+    static const int kRollPerSeconds_ = 60 * 60 * 24;
+};
+
+#endif
@@ -1,8 +1,21 @@
 #include "Logger.h"
 #include "Timestamp.h"
 
-#include <iostream>
-#include <ostream>
+#include <cstdio>
+#include <cstring>
+
+static void defaultOutput(const char* msg, size_t len)
+{
+    ::fwrite(msg, 1, len, stdout);
+}
+
+static void defaultFlush()
+{
+    ::fflush(stdout);
+}
+
+static Logger::OutputFunc g_output = defaultOutput;
+static Logger::FlushFunc g_flush = defaultFlush;
 
 // 获取日志唯一的实力对象接口
 Logger& Logger::instance()
@@ -11,35 +24,56 @@ Logger& Logger::instance()
     return logger;
 }
 
-// 设置日志级别
-void Logger::setLogLevel(int level)
-{
-    logLevel_ = level;
-}
+// 默认不过滤，DEBUG日志是否输出由编译期的OPENDEBUG决定
+std::atomic_int Logger::logLevel_(DEBUG);
 
 /*
  * 写日志 格式
  * [日志级别] time : msg
  */
-void Logger::log(std::string msg)
+void Logger::log(int level, const char* msg)
 {
-    switch (logLevel_) {
+    const char* levelStr = "";
+    switch (level) {
     case INFO:
-        std::cout << "[INFO]";
+        levelStr = "[INFO]";
         break;
     case ERROR:
-        std::cout << "[ERROR]";
+        levelStr = "[ERROR]";
         break;
     case FATAL:
-        std::cout << "[FATAL]";
+        levelStr = "[FATAL]";
         break;
     case DEBUG:
-        std::cout << "[DEBUG]";
+        levelStr = "[DEBUG]";
         break;
     default:
         break;
     }
 
-    std::cout << Timestamp::now().toString()
-              << " : " << msg << std::endl;
-}
\ No newline at end of file
+    // 拼成一整行再交给g_output，不再每条日志都std::endl刷新
+    // 消息自带换行时不再重复换行
+    int msgLen = static_cast<int>(::strlen(msg));
+    if (msgLen > 0 && msg[msgLen - 1] == '\n') {
+        --msgLen;
+    }
+    char buf[1200];
+    int n = snprintf(buf, sizeof buf, "%s%s : %.*s\n",
+        levelStr, Timestamp::now().toString().c_str(), msgLen, msg);
+    size_t len = n < static_cast<int>(sizeof buf) ? static_cast<size_t>(n) : sizeof buf - 1;
+    g_output(buf, len);
+
+    if (level == FATAL) {
+        g_flush(); // 进程马上要退出，把日志刷出去
+    }
+}
+
+void Logger::setOutput(OutputFunc out)
+{
+    g_output = out;
+}
+
+void Logger::setFlush(FlushFunc flush)
+{
+    g_flush = flush;
+}
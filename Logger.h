@@ -5,82 +5,116 @@
 
 #include "noncopyable.h"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
 #include <string>
 
+//
+// 日志级别从低到高 DEBUG < INFO < ERROR < FATAL
+// 编译期下限 编译时定义MYMUDUO_MIN_LOG_LEVEL，低于它的日志宏展开为if (0)，参数都不会求值，
+// 但仍然参与编译，只在日志中使用的变量不会产生unused警告，格式串与参数不符也照样报错
+// 例如 -DMYMUDUO_MIN_LOG_LEVEL=2 只保留LOG_ERROR和LOG_FATAL，LOG_FATAL总是保留
+// 运行期下限 Logger::setLogLevel设置，宏在格式化之前先检查，低于它的日志只有一次原子读的开销
+//
+#define MYMUDUO_LOG_LEVEL_DEBUG 0
+#define MYMUDUO_LOG_LEVEL_INFO 1
+#define MYMUDUO_LOG_LEVEL_ERROR 2
+#define MYMUDUO_LOG_LEVEL_FATAL 3
+
+#ifndef MYMUDUO_MIN_LOG_LEVEL
+#define MYMUDUO_MIN_LOG_LEVEL MYMUDUO_LOG_LEVEL_DEBUG
+#endif
+
 //
 // 用户不需要指定具体怎么调接口写日志, 直接定义宏方便用户写
 // 宏定义时写do while(0)防止一些错误，##__VA_ARGS__是可变参数列表
 // 使用格式
 // LOG_INFO("%s %d", arg1, arg2...)
 //
-#define LOG_INFO(logmsgFormat, ...)                       \
-    do {                                                  \
-        Logger& logger = Logger::instance();              \
-        logger.setLogLevel(INFO);                         \
-        char buf[1024] = { 0 };                           \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf);                                  \
+#define MYMUDUO_LOG(level, logmsgFormat, ...)                 \
+    do {                                                      \
+        if (Logger::logLevel() <= level) {                    \
+            char buf[1024];                                   \
+            snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
+            Logger::instance().log(level, buf);               \
+        }                                                     \
     } while (0)
 
-#define LOG_ERROR(logmsgFormat, ...)                      \
-    do {                                                  \
-        Logger& logger = Logger::instance();              \
-        logger.setLogLevel(ERROR);                        \
-        char buf[1024] = { 0 };                           \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf);                                  \
+// 被关闭的日志，不产生任何代码
+#define MYMUDUO_LOG_DISABLED(logmsgFormat, ...)               \
+    do {                                                      \
+        if (0) {                                              \
+            Logger::checkFormat(logmsgFormat, ##__VA_ARGS__); \
+        }                                                     \
     } while (0)
 
+#if MYMUDUO_MIN_LOG_LEVEL <= MYMUDUO_LOG_LEVEL_INFO
+#define LOG_INFO(logmsgFormat, ...) MYMUDUO_LOG(INFO, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_INFO(logmsgFormat, ...) MYMUDUO_LOG_DISABLED(logmsgFormat, ##__VA_ARGS__)
+#endif
+
+#if MYMUDUO_MIN_LOG_LEVEL <= MYMUDUO_LOG_LEVEL_ERROR
+#define LOG_ERROR(logmsgFormat, ...) MYMUDUO_LOG(ERROR, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(logmsgFormat, ...) MYMUDUO_LOG_DISABLED(logmsgFormat, ##__VA_ARGS__)
+#endif
+
+// FATAL不受级别限制，总是输出并退出进程
 #define LOG_FATAL(logmsgFormat, ...)                      \
     do {                                                  \
-        Logger& logger = Logger::instance();              \
-        logger.setLogLevel(FATAL);                        \
-        char buf[1024] = { 0 };                           \
+        char buf[1024];                                   \
         snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf);                                  \
+        Logger::instance().log(FATAL, buf);               \
         exit(-1);                                         \
     } while (0)
 
-#ifdef OPENDEBUG
-#define LOG_DEBUG(logmsgFormat, ...)                      \
-    do {                                                  \
-        Logger& logger = Logger::instance();              \
-        logger.setLogLevel(DEBUG);                        \
-        char buf[1024] = { 0 };                           \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf);                                  \
-    } while (0)
+#if defined(OPENDEBUG) && MYMUDUO_MIN_LOG_LEVEL <= MYMUDUO_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(logmsgFormat, ...) MYMUDUO_LOG(DEBUG, logmsgFormat, ##__VA_ARGS__)
 #else
-#define LOG_DEBUG(logmsgFormat, ...)
+#define LOG_DEBUG(logmsgFormat, ...) MYMUDUO_LOG_DISABLED(logmsgFormat, ##__VA_ARGS__)
 #endif
 
 /*
- * 定义日志的级别
+ * 定义日志的级别，数值与上面的MYMUDUO_LOG_LEVEL_*一致
+ * DEBUG ： 调试信息，编译时定义OPENDEBUG才打开，默认关闭
  * INFO ： 一般流程信息
  * ERROR ： 一般错误信息
  * FATAL ： 致命错误，导致进程退出，core信息
- * DEBUG ： 调试信息，调试时打开，默认关闭
  */
 enum LogLevel {
-    INFO,
-    ERROR,
-    FATAL,
-    DEBUG,
+    DEBUG = MYMUDUO_LOG_LEVEL_DEBUG,
+    INFO = MYMUDUO_LOG_LEVEL_INFO,
+    ERROR = MYMUDUO_LOG_LEVEL_ERROR,
+    FATAL = MYMUDUO_LOG_LEVEL_FATAL,
 };
 
 // 定义一个日志类，继承noncopyable，不需要拷贝构造和赋值
 // 采用懒汉单例模式，在成员函数中用静态局部变量初始化，线程安全
 class Logger : noncopyable {
 public:
+    // 日志的输出和刷新函数，默认输出到stdout，可以换成AsyncLogging::append写入文件
+    using OutputFunc = void (*)(const char* msg, size_t len);
+    using FlushFunc = void (*)();
+
     // 获取日志唯一的实力对象接口
     static Logger& instance();
-    // 设置日志级别
-    void setLogLevel(int level);
+    // 设置/获取运行期的最低日志级别，低于它的日志在格式化之前就被丢弃，多线程安全
+    static void setLogLevel(int level) { logLevel_.store(level, std::memory_order_relaxed); }
+    static int logLevel() { return logLevel_.load(std::memory_order_relaxed); }
     // 写日志
-    void log(std::string msg);
+    void log(int level, const char* msg);
+
+    // 被关闭的日志宏在if (0)中调用，只用来让编译器检查格式串和参数
+    __attribute__((format(printf, 1, 2))) static void checkFormat(const char*, ...) {}
+
+    static void setOutput(OutputFunc out);
+    static void setFlush(FlushFunc flush);
 
 private:
-    int logLevel_;
+    static std::atomic_int logLevel_;
     Logger() {}; // 构造函数私有化
 };
 
@@ -0,0 +1,87 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#pragma once
+#include "noncopyable.h"
+
+#include <atomic>
+#include <thread>
+
+// 侵入式队列的节点，需要入队的对象继承MpscNode
+struct MpscNode {
+    std::atomic<MpscNode*> next { nullptr };
+};
+
+//
+// 侵入式无锁多生产者单消费者队列(Dmitry Vyukov的算法)
+// push可以在任意线程调用，只需要一次原子交换，不需要加锁
+// pop只能在唯一的消费者线程调用
+// 队列不负责节点的内存，节点出队后由调用者释放
+//
+class MpscQueue : noncopyable {
+public:
+    MpscQueue()
+        : head_(&stub_)
+        , tail_(&stub_)
+    {
+    }
+
+    // 生产者 在任意线程调用
+    void push(MpscNode* node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        MpscNode* prev = head_.exchange(node, std::memory_order_acq_rel);
+        // 在exchange和下面的store之间，消费者看到的链表是断开的，pop中需要等待
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 消费者 只在一个线程调用 队列为空返回nullptr
+    MpscNode* pop()
+    {
+        MpscNode* tail = tail_;
+        MpscNode* next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &stub_) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next != nullptr) {
+            tail_ = next;
+            return tail;
+        }
+
+        if (tail != head_.load(std::memory_order_acquire)) {
+            // 有生产者正在push，链表暂时断开，等待它连上
+            next = waitNext(tail);
+            tail_ = next;
+            return tail;
+        }
+
+        // tail是最后一个节点，把stub_放回队尾后才能把tail取出来
+        push(&stub_);
+        next = waitNext(tail);
+        tail_ = next;
+        return tail;
+    }
+
+private:
+    static MpscNode* waitNext(MpscNode* node)
+    {
+        MpscNode* next;
+        while ((next = node->next.load(std::memory_order_acquire)) == nullptr) {
+            std::this_thread::yield();
+        }
+        return next;
+    }
+
+    std::atomic<MpscNode*> head_; // 生产者写入的一端
+    MpscNode* tail_; // 消费者读取的一端，只有消费者访问
+    MpscNode stub_;
+};
+
+#endif
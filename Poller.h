@@ -27,6 +27,9 @@ public:
     // 判断参数channel是否在当前Poller中
     bool hasChannel(Channel* channel) const;
 
+    // 是否支持Channel的边沿触发模式
+    virtual bool supportsEdgeTriggered() const { return false; }
+
     // EventLoop通过这个接口获取默认的IO复用的实例 类似与单例模式的接口
     static Poller* newDefaultPoller(EventLoop* loop);
 
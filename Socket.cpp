@@ -25,6 +25,15 @@ int Socket::createNonblocking()
     return sockfd;
 }
 
+int Socket::createNonblockingUdp()
+{
+    int sockfd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (sockfd < 0) {
+        LOG_FATAL("%s-%s-%d udp socket create error: %d\n", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
+    return sockfd;
+}
+
 void Socket::bindAddress(const InetAddress& loacladdr)
 {
     if (0 != ::bind(sockfd_, (sockaddr*)loacladdr.getSockAddr(), sizeof(sockaddr_in))) {
@@ -34,7 +43,8 @@ void Socket::bindAddress(const InetAddress& loacladdr)
 
 void Socket::listen()
 {
-    if (0 != ::listen(sockfd_, 1024)) {
+    // 连接风暴时全连接队列越长越不容易丢连接，实际长度受net.core.somaxconn限制
+    if (0 != ::listen(sockfd_, SOMAXCONN)) {
         LOG_FATAL("listen sockfd: %d fail\n", sockfd_);
     }
 }
@@ -96,6 +106,25 @@ void Socket::setKeepAlive(bool on)
     ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, static_cast<socklen_t>(sizeof optval));
 }
 
+// 开启SO_ZEROCOPY，之后带MSG_ZEROCOPY的send才会直接引用用户内存
+bool Socket::setZeroCopy(bool on)
+{
+#ifdef SO_ZEROCOPY
+    int optval = on ? 1 : 0;
+    return ::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &optval, static_cast<socklen_t>(sizeof optval)) == 0;
+#else
+    return false;
+#endif
+}
+
+void Socket::setLinger(bool on, int seconds)
+{
+    struct linger lin;
+    lin.l_onoff = on ? 1 : 0;
+    lin.l_linger = seconds;
+    ::setsockopt(sockfd_, SOL_SOCKET, SO_LINGER, &lin, static_cast<socklen_t>(sizeof lin));
+}
+
 // 通过sockfd来获取ip地址和端口号
 sockaddr_in Socket::getLocalAddr(int sockfd)
 {
@@ -16,6 +16,7 @@ public:
     ~Socket();
 
     static int createNonblocking();
+    static int createNonblockingUdp();
 
     int fd() const
     {
@@ -32,6 +33,10 @@ public:
     void setReuseAddr(bool on);
     void setReusePort(bool on);
     void setKeepAlive(bool on);
+    // 允许send使用MSG_ZEROCOPY，内核不支持时返回false
+    bool setZeroCopy(bool on);
+    // SO_LINGER，on为true且seconds为0时close直接发RST并丢弃发送队列中的数据
+    void setLinger(bool on, int seconds);
 
     static struct sockaddr_in getLocalAddr(int sockfd);
     static struct sockaddr_in getPeerAddr(int sockfd);
@@ -0,0 +1,235 @@
+#include "StringSearch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MYMUDUO_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace StringSearch {
+namespace {
+
+// 逐字节查找，也用于处理SIMD实现不足一个向量的尾部
+const char* findByteScalar(const char* begin, const char* end, char c)
+{
+    for (const char* p = begin; p < end; ++p) {
+        if (*p == c) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+const char* findCRLFScalar(const char* begin, const char* end)
+{
+    for (const char* p = begin; p + 1 < end; ++p) {
+        if (p[0] == '\r' && p[1] == '\n') {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+const char* findDoubleCRLFScalar(const char* begin, const char* end)
+{
+    for (const char* p = begin; p + 3 < end; ++p) {
+        if (p[0] == '\r' && p[1] == '\n' && p[2] == '\r' && p[3] == '\n') {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+#ifdef MYMUDUO_X86_SIMD
+
+// 多字节分隔符的查找 从p, p+1, p+2...处各加载一个向量，分别与分隔符的第0, 1, 2...个字节比较后按位与，
+// 结果中置位的字节就是分隔符的起始位置，一次检查16/32个起始位置，最后一个向量之后的部分逐字节查找
+
+__attribute__((target("sse2"))) const char* findByteSse2(const char* begin, const char* end, char c)
+{
+    const __m128i needle = _mm_set1_epi8(c);
+    const char* p = begin;
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findByteScalar(p, end, c);
+}
+
+__attribute__((target("sse2"))) const char* findCRLFSse2(const char* begin, const char* end)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 17; p += 16) {
+        __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(v0, cr), _mm_cmpeq_epi8(v1, lf));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findCRLFScalar(p, end);
+}
+
+__attribute__((target("sse2"))) const char* findDoubleCRLFSse2(const char* begin, const char* end)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 19; p += 16) {
+        __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2));
+        __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 3));
+        __m128i eq = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(v0, cr), _mm_cmpeq_epi8(v1, lf)),
+            _mm_and_si128(_mm_cmpeq_epi8(v2, cr), _mm_cmpeq_epi8(v3, lf)));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findDoubleCRLFScalar(p, end);
+}
+
+__attribute__((target("avx2"))) const char* findByteAvx2(const char* begin, const char* end, char c)
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char* p = begin;
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findByteSse2(p, end, c);
+}
+
+__attribute__((target("avx2"))) const char* findCRLFAvx2(const char* begin, const char* end)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 33; p += 32) {
+        __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(v0, cr), _mm256_cmpeq_epi8(v1, lf));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findCRLFSse2(p, end);
+}
+
+__attribute__((target("avx2"))) const char* findDoubleCRLFAvx2(const char* begin, const char* end)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 35; p += 32) {
+        __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        __m256i v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 2));
+        __m256i v3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 3));
+        __m256i eq = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(v0, cr), _mm256_cmpeq_epi8(v1, lf)),
+            _mm256_and_si256(_mm256_cmpeq_epi8(v2, cr), _mm256_cmpeq_epi8(v3, lf)));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findDoubleCRLFSse2(p, end);
+}
+
+#endif // MYMUDUO_X86_SIMD
+
+const Kernels kScalarKernels = { findByteScalar, findCRLFScalar, findDoubleCRLFScalar };
+#ifdef MYMUDUO_X86_SIMD
+const Kernels kSse2Kernels = { findByteSse2, findCRLFSse2, findDoubleCRLFSse2 };
+const Kernels kAvx2Kernels = { findByteAvx2, findCRLFAvx2, findDoubleCRLFAvx2 };
+#endif
+
+Implementation g_implementation = kScalar;
+
+bool cpuSupports(Implementation impl)
+{
+#ifdef MYMUDUO_X86_SIMD
+    __builtin_cpu_init();
+    switch (impl) {
+    case kScalar:
+        return true;
+    case kSse2:
+        return __builtin_cpu_supports("sse2");
+    case kAvx2:
+        return __builtin_cpu_supports("avx2");
+    }
+    return false;
+#else
+    return impl == kScalar;
+#endif
+}
+
+// 在main之前选择CPU支持的最快实现，在此之前的查找使用逐字节实现
+struct KernelSelector {
+    KernelSelector()
+    {
+        if (!setImplementation(kAvx2) && !setImplementation(kSse2)) {
+            setImplementation(kScalar);
+        }
+    }
+};
+KernelSelector g_kernelSelector;
+
+} // namespace
+
+Kernels g_kernels = { findByteScalar, findCRLFScalar, findDoubleCRLFScalar };
+
+Implementation implementation()
+{
+    return g_implementation;
+}
+
+const char* implementationName(Implementation impl)
+{
+    switch (impl) {
+    case kScalar:
+        return "scalar";
+    case kSse2:
+        return "sse2";
+    case kAvx2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+bool setImplementation(Implementation impl)
+{
+    if (!cpuSupports(impl)) {
+        return false;
+    }
+
+    switch (impl) {
+    case kScalar:
+        g_kernels = kScalarKernels;
+        break;
+#ifdef MYMUDUO_X86_SIMD
+    case kSse2:
+        g_kernels = kSse2Kernels;
+        break;
+    case kAvx2:
+        g_kernels = kAvx2Kernels;
+        break;
+#else
+    default:
+        return false;
+#endif
+    }
+    g_implementation = impl;
+    return true;
+}
+}
@@ -0,0 +1,54 @@
+#ifndef STRINGSEARCH_H
+#define STRINGSEARCH_H
+
+#pragma once
+
+//
+// 在[begin, end)中查找分隔符，找到返回第一次出现的位置，找不到返回nullptr
+// HTTP请求头解析时每一行都要查找\r\n和:，逐字节比较是解析的主要开销
+// x86上有SSE2和AVX2两种实现，一次比较16/32字节，启动时按CPU支持的指令集选择，其他平台使用逐字节的实现
+//
+namespace StringSearch {
+enum Implementation {
+    kScalar,
+    kSse2,
+    kAvx2,
+};
+
+struct Kernels {
+    const char* (*findByte)(const char* begin, const char* end, char c);
+    const char* (*findCRLF)(const char* begin, const char* end);
+    const char* (*findDoubleCRLF)(const char* begin, const char* end);
+};
+extern Kernels g_kernels; // 当前使用的实现，启动时选择
+
+Implementation implementation();
+const char* implementationName(Implementation impl);
+// 切换实现，用于测试和性能对比，CPU不支持时返回false，不能与查找并发调用
+bool setImplementation(Implementation impl);
+
+inline const char* findByte(const char* begin, const char* end, char c)
+{
+    return g_kernels.findByte(begin, end, c);
+}
+
+// 查找\r\n
+inline const char* findCRLF(const char* begin, const char* end)
+{
+    return g_kernels.findCRLF(begin, end);
+}
+
+// 查找\n
+inline const char* findEOL(const char* begin, const char* end)
+{
+    return g_kernels.findByte(begin, end, '\n');
+}
+
+// 查找\r\n\r\n，即HTTP请求头的结尾
+inline const char* findDoubleCRLF(const char* begin, const char* end)
+{
+    return g_kernels.findDoubleCRLF(begin, end);
+}
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "TcpConnection.h"
+#include "BufferPool.h"
 #include "Callbacks.h"
 #include "Channel.h"
 #include "EventLoop.h"
@@ -7,7 +8,11 @@
 
 #include <cerrno>
 #include <cstddef>
+#include <cstring>
 #include <functional>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -51,6 +56,15 @@ TcpConnection::TcpConnection(EventLoop* loop,
     , localAddr_(localAddr)
     , peerAddr_(peerAddr)
     , hightWaterMark_(64 * 1024 * 1024) // 64M
+    , inputBuffer_(0) // 第一次读数据时才分配内存，或者从BufferPool借
+    , reportedPendingBytes_(0)
+    , edgeTriggered_(false)
+    , pauseReadOnHighWaterMark_(false)
+    , pausedByHighWaterMark_(false)
+    , useBufferPool_(true)
+    , zeroCopy_(false)
+    , zeroCopySocket_(false)
+    , zeroCopyThreshold_(kDefaultZeroCopyThreshold)
 {
     // 给Channel设置相应的回调函数，Poller通知Channel感兴趣的事件发送了，Channel会回调相应的操作函数
     channel_->setReadCallBack(std::bind(&TcpConnection::handleRead, this, std::placeholders::_1));
@@ -58,14 +72,40 @@ TcpConnection::TcpConnection(EventLoop* loop,
     channel_->setCloseCallBack(std::bind(&TcpConnection::handleClose, this));
     channel_->setErrorCallBack(std::bind(&TcpConnection::handleError, this));
 
+    inputBuffer_.setShrinkPolicy(kShrinkThreshold, kShrinkLowWaterMark, kShrinkAfterReads);
+
     LOG_INFO("TcpConnection::connector[%s] at fd=%d\n", name_.c_str(), sockfd);
     socket_->setKeepAlive(true);
+
+    // 在mainloop分配连接时就计入，连续到来的连接可以立刻看到前一个连接的负载
+    loop_->addConnectionCount(1);
 }
 
 TcpConnection::~TcpConnection()
 {
     LOG_INFO("TcpConnection::disconnector[%s] at fd=%d state=%d\n",
         name_.c_str(), channel_->fd(), (int)state_);
+
+    // 还有MSG_ZEROCOPY数据没有收到完成通知，内核可能还会从用户内存发送或重传，
+    // 先以SO_LINGER{1,0}关闭socket丢弃发送队列，再让outputBuffer_释放这些string
+    if (outputBuffer_.zeroCopyPinnedBytes() > 0) {
+        socket_->setLinger(true, 0);
+        socket_.reset();
+    }
+}
+
+bool TcpConnection::isWriting() const
+{
+    return edgeTriggered_ ? outputBuffer_.readableBytes() > 0 : channel_->isWriting();
+}
+
+void TcpConnection::updatePendingBytes()
+{
+    size_t pending = outputBuffer_.readableBytes();
+    if (pending != reportedPendingBytes_) {
+        loop_->addPendingBytes(static_cast<int64_t>(pending) - static_cast<int64_t>(reportedPendingBytes_));
+        reportedPendingBytes_ = pending;
+    }
 }
 
 // 发送数据
@@ -73,9 +113,23 @@ void TcpConnection::send(const std::string& buf)
 {
     if (state_ == kConnected) {
         if (loop_->isInLoopThread()) {
-            sendInLoop(buf.c_str(), buf.size());
+            sendInLoop(buf.data(), buf.size());
         } else {
-            loop_->runInloop(std::bind(&TcpConnection::sendInLoop, this, buf.c_str(), buf.size()));
+            send(std::string(buf)); // 拷贝一份交给loop线程，不能只传buf.c_str()，调用返回后buf可能已经释放
+        }
+    }
+}
+
+void TcpConnection::send(std::string&& buf)
+{
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(buf);
+        } else {
+            // string移动进任务中，只有任务对象本身一次内存分配，数据不拷贝
+            loop_->runInloop([self = shared_from_this(), data = std::move(buf)]() mutable {
+                self->sendInLoop(data);
+            });
         }
     }
 }
@@ -87,64 +141,345 @@ void TcpConnection::send(Buffer* buf)
             sendInLoop(buf->peek(), buf->readableBytes());
             buf->retrieveAll();
         } else {
-            loop_->runInloop(std::bind(&TcpConnection::sendInLoop, this,
-                buf->retrieveAllAsString().c_str(), buf->retrieveAllAsString().size()));
+            send(buf->retrieveAllAsString());
+        }
+    }
+}
+
+void TcpConnection::send(Buffer&& buf)
+{
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(buf.peek(), buf.readableBytes());
+            buf.retrieveAll();
+        } else {
+            loop_->runInloop([self = shared_from_this(), data = std::move(buf)]() {
+                self->sendInLoop(data.peek(), data.readableBytes());
+            });
         }
     }
 }
 
-// 发送数据 应用写的快，内核发送数据较慢，需要把待发送数据写入缓冲区，并且设置了水位回调
+void TcpConnection::send(const std::shared_ptr<const std::string>& buf, size_t offset, size_t len)
+{
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(buf, offset, len);
+        } else {
+            loop_->runInloop([self = shared_from_this(), buf, offset, len]() {
+                self->sendInLoop(buf, offset, len);
+            });
+        }
+    }
+}
+
+size_t TcpConnection::writeDirectly(const char* data, size_t len, bool* faultError)
+{
+    // 一开始注册的Channel都是对reading感兴趣，监听EPOLLIN事件，没有监听EPOLLOUT事件
+    if (isWriting() || outputBuffer_.readableBytes() != 0) {
+        return 0; // 还有排队的数据，直接写会打乱顺序
+    }
+
+    // 发送数据
+    ssize_t nwrote = ::write(channel_->fd(), data, len);
+    if (nwrote >= 0) { // 发送成功
+        if (static_cast<size_t>(nwrote) == len && writeCompleteCallback_) {
+            // 数据一次性发送完毕，直接执行回调
+            // 并且不需要再给Channel注册EPOLLOUT事件
+            loop_->queueInloop(std::bind(writeCompleteCallback_, shared_from_this()));
+        }
+        return nwrote;
+    }
+
+    // nwrote < 0
+    if (errno != EWOULDBLOCK) {
+        LOG_ERROR("TcpConnection::sendInLoop\n");
+        if (errno == EPIPE || errno == ECONNRESET) { // SIGPIPE RESET
+            *faultError = true;
+        }
+    }
+    return 0;
+}
+
+// 说明当前这次的write没有把数据全部发送出去，剩余的数据已经追加到outputBuffer_缓冲区中，
+// 检查高水位，LT模式下给Channel注册EPOLLOUT事件，只要TCP的发送缓冲区有空间，
+// 就会通知相应的socket即Channel EPOLLOUT事件，调用Channel的writeCallback_回调，
+// 即绑定的TcpConnection::handleWrite，直到数据全部发送完成；
+// ET模式下EPOLLOUT一直保持注册，不需要修改，发送缓冲区从满变为可写时handleWrite同样会被调用
+void TcpConnection::afterAppendOutput(size_t oldLen, size_t added)
+{
+    checkHighWaterMark(oldLen, added);
+    updatePendingBytes();
+    if (!edgeTriggered_ && !channel_->isWriting()) {
+        channel_->enableWriting(); // 注册Channel的写事件，Poller会给Channel通知EPOLLOUT事件
+    }
+}
+
 void TcpConnection::sendInLoop(const void* data, size_t len)
 {
-    ssize_t nwrote = 0; // 已发送字节数
-    size_t remaining = len; // 未发送字节数
+    if (state_ == kDisconnected) { // 之前这个connection调用过shutdown关闭，不能发送数据
+        LOG_ERROR("disconnected, give up writing!\n");
+        return;
+    }
+
+    bool faultError = false;
+    size_t nwrote = writeDirectly(static_cast<const char*>(data), len, &faultError);
+    if (!faultError && nwrote < len) {
+        size_t oldLen = outputBuffer_.readableBytes();
+        // remaining的数据写入缓冲区
+        outputBuffer_.append(static_cast<const char*>(data) + nwrote, len - nwrote);
+        afterAppendOutput(oldLen, len - nwrote);
+    }
+}
+
+void TcpConnection::sendInLoop(std::string& buf)
+{
+    if (state_ == kDisconnected) {
+        LOG_ERROR("disconnected, give up writing!\n");
+        return;
+    }
+
+    if (zeroCopy_ && buf.size() >= zeroCopyThreshold_) {
+        // 转成共享string，等完成通知时再释放，只是移动不拷贝
+        size_t len = buf.size();
+        sendZeroCopyInLoop(std::make_shared<const std::string>(std::move(buf)), 0, len);
+        return;
+    }
+
     bool faultError = false;
+    size_t len = buf.size();
+    size_t nwrote = writeDirectly(buf.data(), len, &faultError);
+    if (!faultError && nwrote < len) {
+        size_t oldLen = outputBuffer_.readableBytes();
+        outputBuffer_.append(std::move(buf)); // 接管string的内存
+        if (nwrote > 0) {
+            // 能直接写出说明outputBuffer_原本是空的，丢弃的正好是这个string已发送的前nwrote字节
+            outputBuffer_.retrieve(nwrote);
+        }
+        afterAppendOutput(oldLen, len - nwrote);
+    }
+}
 
-    if (state_ == kDisconnected) { // 之前这个connection调用过shutdown关闭，不能发送数据
+void TcpConnection::sendInLoop(const std::shared_ptr<const std::string>& buf, size_t offset, size_t len)
+{
+    if (state_ == kDisconnected) {
         LOG_ERROR("disconnected, give up writing!\n");
         return;
     }
 
-    // 一开始注册的Channel都是对reading感兴趣，监听EPOLLIN事件，没有监听EPOLLOUT事件
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0) {
-        // 发送数据
-        nwrote = ::write(channel_->fd(), data, len);
-        if (nwrote >= 0) { // 发送成功
-            remaining = len - nwrote;
-            if (remaining == 0 && writeCompleteCallback_) {
-                // 数据一次性发送完毕，直接执行回调
-                // 并且不需要再给Channel注册EPOLLOUT事件
-                loop_->queueInloop(std::bind(writeCompleteCallback_, shared_from_this()));
-            }
-        } else { // nwrote < 0
-            nwrote = 0;
+    if (zeroCopy_ && len >= zeroCopyThreshold_) {
+        sendZeroCopyInLoop(buf, offset, len);
+        return;
+    }
+
+    bool faultError = false;
+    size_t nwrote = writeDirectly(buf->data() + offset, len, &faultError);
+    if (!faultError && nwrote < len) {
+        size_t oldLen = outputBuffer_.readableBytes();
+        outputBuffer_.append(buf, offset + nwrote, len - nwrote); // 只增加引用计数
+        afterAppendOutput(oldLen, len - nwrote);
+    }
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t length, const SendFileCompleteCallback& cb)
+{
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendFileInLoop(fd, offset, length, cb);
+        } else {
+            loop_->runInloop(std::bind(&TcpConnection::sendFileInLoop, shared_from_this(),
+                fd, offset, length, cb));
+        }
+    } else if (cb) {
+        loop_->queueInloop(std::bind(cb, shared_from_this(), false));
+    }
+}
+
+// 发送文件 与sendInLoop相同，没有排队的数据时先直接sendfile，剩余部分作为文件区域追加到outputBuffer_，
+// 由handleWrite在EPOLLOUT时继续sendfile
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t length, const SendFileCompleteCallback& cb)
+{
+    ssize_t nwrote = 0;
+    size_t remaining = length;
+    bool faultError = false;
+
+    if (state_ == kDisconnected) {
+        LOG_ERROR("disconnected, give up sending file!\n");
+        if (cb) {
+            loop_->queueInloop(std::bind(cb, shared_from_this(), false));
+        }
+        return;
+    }
+
+    if (!isWriting() && outputBuffer_.readableBytes() == 0 && length > 0) {
+        off_t off = offset; // sendfile会更新off，但不改变fd的文件偏移
+        nwrote = ::sendfile(channel_->fd(), fd, &off, length);
+        if (nwrote > 0) {
+            remaining = length - nwrote;
+            offset = off;
+        } else if (nwrote == 0) { // 文件长度不足length，剩余部分永远发不出去
+            LOG_ERROR("TcpConnection::sendFileInLoop file fd=%d is shorter than expected\n", fd);
+            faultError = true;
+        } else {
             if (errno != EWOULDBLOCK) {
-                LOG_ERROR("TcpConnection::sendInLoop\n");
-                if (errno == EPIPE || errno == ECONNRESET) { // SIGPIPE RESET
-                    faultError = true;
-                }
+                LOG_ERROR("TcpConnection::sendFileInLoop errno=%d\n", errno);
+                faultError = true; // EPIPE ECONNRESET或者fd不支持sendfile
             }
         }
     }
 
-    // 说明当前这次的write没有把数据全部发送出去，剩余的数据需要保存到outputBuffer_缓冲区中，
-    // 并且个Channel注册EPOLLOUT事件，由于Poller工作在LT模式，只要TCP的发送缓冲区有空间，
-    // 会通知相应的socket即Channel EPOLLOUT事件，调用Channel的writeCallback_回调，
-    // 即绑定的TcpConnection::handleWrite，直到数据全部发送完成
-    if (!faultError && remaining > 0) {
-        // 当前outputBuffer_缓冲区中剩余的待发送数据的长度
-        size_t oldLen = outputBuffer_.readableBytes();
-        if (oldLen + remaining >= hightWaterMark_
-            && oldLen < hightWaterMark_
-            && highWaterMarkCallback_) {
-            loop_->queueInloop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
+    if (faultError) {
+        if (cb) {
+            loop_->queueInloop(std::bind(cb, shared_from_this(), false));
         }
-        // remaining的数据写入缓冲区
-        outputBuffer_.append(static_cast<const char*>(data) + nwrote, remaining);
-        if (!channel_->isWriting()) {
-            channel_->enableWriting(); // 注册Channel的写事件，Poller会给Channel通知EPOLLOUT事件
+        return;
+    }
+
+    if (remaining == 0) {
+        // 文件一次性发送完毕，不需要注册EPOLLOUT事件
+        if (cb) {
+            loop_->queueInloop(std::bind(cb, shared_from_this(), true));
+        }
+        if (writeCompleteCallback_) {
+            loop_->queueInloop(std::bind(writeCompleteCallback_, shared_from_this()));
         }
+        return;
+    }
+
+    size_t oldLen = outputBuffer_.readableBytes();
+
+    // 文件区域在handleWrite中retrieve完成或者连接关闭时clear丢弃时回调，
+    // 这两处TcpConnection都还存活，回调放到queueInloop中执行，避免在操作outputBuffer_的过程中重入
+    ChainBuffer::FileDoneCallback done;
+    if (cb) {
+        done = [this, cb](bool ok) {
+            loop_->queueInloop(std::bind(cb, shared_from_this(), ok));
+        };
+    }
+    outputBuffer_.appendFile(fd, offset, remaining, std::move(done));
+    afterAppendOutput(oldLen, remaining);
+}
+
+void TcpConnection::setZeroCopy(bool on, size_t threshold)
+{
+    zeroCopyThreshold_ = threshold;
+    if (on && !socket_->setZeroCopy(true)) {
+        LOG_ERROR("TcpConnection::setZeroCopy [%s] SO_ZEROCOPY is not supported\n", name_.c_str());
+        on = false;
     }
+    // 关闭时只是之后的发送不再走MSG_ZEROCOPY，socket上的SO_ZEROCOPY保留，已经发出的数据的完成通知照常读取
+    zeroCopy_ = on;
+    zeroCopySocket_ = zeroCopySocket_ || on;
+}
+
+// 与sendInLoop相同，没有排队的数据时直接发送，只是数据先挂到outputBuffer_上再由writeFd用MSG_ZEROCOPY发送，
+// 发送完的部分也要留在outputBuffer_中等待完成通知
+void TcpConnection::sendZeroCopyInLoop(const std::shared_ptr<const std::string>& buf, size_t offset, size_t len)
+{
+    size_t oldLen = outputBuffer_.readableBytes();
+    bool idle = !isWriting() && oldLen == 0;
+    outputBuffer_.appendZeroCopy(buf, offset, len);
+
+    if (idle) {
+        int savedErrno = 0;
+        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+        if (n > 0) {
+            outputBuffer_.retrieve(n);
+        } else if (n < 0 && savedErrno != EWOULDBLOCK) {
+            LOG_ERROR("TcpConnection::sendZeroCopyInLoop errno=%d\n", savedErrno);
+            if (savedErrno == EPIPE || savedErrno == ECONNRESET) {
+                outputBuffer_.retrieveAll(); // 对端已经关闭，与sendInLoop一样放弃发送
+            }
+        }
+
+        if (outputBuffer_.readableBytes() == 0) {
+            updatePendingBytes();
+            if (n > 0 && writeCompleteCallback_) {
+                loop_->queueInloop(std::bind(writeCompleteCallback_, shared_from_this()));
+            }
+            return;
+        }
+    }
+    afterAppendOutput(oldLen, outputBuffer_.readableBytes() - oldLen);
+}
+
+bool TcpConnection::readZeroCopyCompletions()
+{
+    bool got = false;
+    char control[128];
+    for (;;) {
+        struct msghdr msg;
+        ::memset(&msg, 0, sizeof msg);
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof control;
+
+        if (::recvmsg(channel_->fd(), &msg, MSG_ERRQUEUE) < 0) {
+            break; // EAGAIN 错误队列已经读空
+        }
+
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            bool recverr = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+            if (!recverr) {
+                continue;
+            }
+            const struct sock_extended_err* serr = reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(cm));
+            if (serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY && serr->ee_errno == 0) {
+                // ee_info到ee_data是这次通知覆盖的发送序号区间
+                outputBuffer_.completeZeroCopy(serr->ee_info, serr->ee_data,
+                    (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+                got = true;
+            }
+        }
+    }
+    return got;
+}
+
+void TcpConnection::checkHighWaterMark(size_t oldLen, size_t added)
+{
+    size_t newLen = oldLen + added;
+    if (newLen < hightWaterMark_) {
+        return;
+    }
+
+    if (oldLen < hightWaterMark_ && highWaterMarkCallback_) {
+        loop_->queueInloop(std::bind(highWaterMarkCallback_, shared_from_this(), newLen));
+    }
+    if (pauseReadOnHighWaterMark_ && reading_) {
+        stopReadInLoop();
+        pausedByHighWaterMark_ = true;
+    }
+}
+
+void TcpConnection::startRead()
+{
+    loop_->runInloop(std::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::startReadInLoop()
+{
+    pausedByHighWaterMark_ = false;
+    if (state_ != kConnected || reading_) {
+        return;
+    }
+    channel_->enableReading();
+    reading_ = true;
+}
+
+void TcpConnection::stopRead()
+{
+    loop_->runInloop(std::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopReadInLoop()
+{
+    // 用户主动停止读取，即使之前已经因为高水位自动暂停，积压发送完后也不能再自动恢复，要等用户startRead
+    pausedByHighWaterMark_ = false;
+    if (state_ != kConnected || !reading_) {
+        return;
+    }
+    channel_->disableReading();
+    reading_ = false;
 }
 
 void TcpConnection::shutdown()
@@ -156,7 +491,7 @@ void TcpConnection::shutdown()
 }
 void TcpConnection::shutdownInLoop()
 {
-    if (!channel_->isWriting()) { // 说明outputBuffer_中的数据全部发送完毕
+    if (!isWriting()) { // 说明outputBuffer_中的数据全部发送完毕
         // 关闭写端 会触发EPOLLHUP事件，在Channel中有判断
         // (revents_ & EPOLLHUP) && !(revents_ & EPOLLIN) 回调closeCallback_
         // 即初始化TcpConnection时绑定的TcpConnection::handleClose
@@ -184,7 +519,19 @@ void TcpConnection::connectEstablished()
 {
     setState(kConnected);
     channel_->tie(shared_from_this()); // 记录TcpConnection对象，保证没有释放才进行操作
-    channel_->enableReading(); // 向Poller注册Channel的EPOLLIN事件
+    if (useBufferPool_) {
+        // 收发缓冲区的内存都从loop的BufferPool借，空闲时不持有内存
+        outputBuffer_.setPool(loop_->bufferPool());
+    }
+    if (edgeTriggered_ && !loop_->supportsEdgeTriggered()) {
+        LOG_ERROR("TcpConnection::connectEstablished [%s] poller does not support EPOLLET, use LT\n", name_.c_str());
+        edgeTriggered_ = false;
+    }
+    if (edgeTriggered_) {
+        channel_->enableReadWriteEdgeTriggered(); // EPOLLIN | EPOLLOUT | EPOLLET，之后不再修改写事件
+    } else {
+        channel_->enableReading(); // 向Poller注册Channel的EPOLLIN事件
+    }
 
     // 新连接建立，执行连接回调
     connectionCallback_(shared_from_this());
@@ -200,6 +547,13 @@ void TcpConnection::connectDestroyed()
         connectionCallback_(shared_from_this());
     }
     channel_->remove(); // 在Poller中删除Channel
+
+    // 丢弃没处理、没发送的数据，内存还给BufferPool，并从loop_的负载统计中减去这个连接
+    inputBuffer_.retrieveAll();
+    releaseIdleInputBuffer();
+    outputBuffer_.clear();
+    updatePendingBytes();
+    loop_->addConnectionCount(-1);
 }
 
 void TcpConnection::setTcpNoDelay(bool on)
@@ -209,47 +563,102 @@ void TcpConnection::setTcpNoDelay(bool on)
 
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
-    int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
-    if (n > 0) {
-        // 已建立连接的用户，有可读事件发生，调用用户传入的回调操作onMessage
-        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
-    } else if (n == 0) { // 连接关闭
-        handleClose();
-    } else {
-        errno = savedErrno;
-        LOG_ERROR("TcpConnection::handleRead error\n");
-        handleError();
+    // LT模式下每次可读事件只读一次，ET模式下可读事件只通知一次，要一直读到EAGAIN
+    // 用户回调中关闭连接或者停止读时isReading为false，不再继续读
+    if (useBufferPool_ && !inputBuffer_.hasStorage()) {
+        // 按自适应读取预计的读取量借内存，避免借来之后readFd马上又扩容
+        size_t expected = std::max(inputBuffer_.readAheadSize() + Buffer::kCheapPrepend, Buffer::kInitialSize);
+        inputBuffer_.adoptStorage(loop_->bufferPool()->acquire(expected));
+    }
+
+    do {
+        int savedErrno = 0;
+        ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+        if (n > 0) {
+            // 已建立连接的用户，有可读事件发生，调用用户传入的回调操作onMessage
+            messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+        } else if (n == 0) { // 连接关闭
+            handleClose();
+            return;
+        } else {
+            if (edgeTriggered_ && (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK)) {
+                break; // 内核缓冲区已经读空
+            }
+            errno = savedErrno;
+            LOG_ERROR("TcpConnection::handleRead error\n");
+            handleError();
+            break;
+        }
+    } while (edgeTriggered_ && channel_->isReading());
+
+    releaseIdleInputBuffer(); // 用户把数据都取走了，内存还给loop的BufferPool
+
+    // 没有取走全部数据时，连续多次只剩少量数据就释放之前大数据扩容出来的内存
+    if (inputBuffer_.hasStorage()) {
+        size_t reclaimed = inputBuffer_.maybeShrink();
+        if (reclaimed > 0) {
+            loop_->addReclaimedBufferBytes(reclaimed);
+        }
+    }
+}
+
+void TcpConnection::releaseIdleInputBuffer()
+{
+    if (useBufferPool_ && inputBuffer_.hasStorage() && inputBuffer_.readableBytes() == 0) {
+        loop_->bufferPool()->release(inputBuffer_.releaseStorage());
     }
 }
 
 void TcpConnection::handleWrite()
 {
-    if (channel_->isWriting()) {
-        int savedErrno = 0;
-        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+    if (!isWriting()) {
+        // ET模式下EPOLLOUT一直注册，发送缓冲区有空间时即使没有待发送数据也会通知
+        if (!edgeTriggered_) {
+            LOG_ERROR("TcpConnection fd = %d is down, no more writing\n", channel_->fd());
+        }
+        return;
+    }
+
+    int savedErrno = 0;
+    ssize_t n = 0;
+    // ET模式下EPOLLOUT只在发送缓冲区由满变为不满时通知一次，要一直写到outputBuffer_为空或者EAGAIN
+    do {
+        n = outputBuffer_.writeFd(channel_->fd(), &savedErrno); // writev一次发送多段数据
         if (n > 0) {
             outputBuffer_.retrieve(n);
-            if (outputBuffer_.readableBytes() == 0) {
-                // 表示这一轮已经读取完缓冲区的数据写入完成
+            updatePendingBytes();
+        }
+    } while (edgeTriggered_ && n > 0 && outputBuffer_.readableBytes() > 0);
+
+    if (n > 0) {
+        if (outputBuffer_.readableBytes() == 0) {
+            // 表示这一轮已经读取完缓冲区的数据写入完成
+            if (!edgeTriggered_) {
                 channel_->disableWriting();
-                if (writeCompleteCallback_) {
-                    // 唤醒loop_对应的thread线程，执行回调
-                    // 不过TcpConnection是属于某个subloop，一个subloop属于一个thread，
-                    // 能够调用到TcpConnection::handleWrite应该loop_就在自己的thread
-                    loop_->queueInloop(std::bind(writeCompleteCallback_, shared_from_this()));
-                }
-
-                if (state_ == kDisconnecting) {
-                    // TcpConnection状态是正在关闭，写完这一轮数据就关闭连接
-                    shutdownInLoop();
-                }
             }
-        } else {
-            LOG_ERROR("TcpConnection::handleWrite error\n");
+            if (writeCompleteCallback_) {
+                // 唤醒loop_对应的thread线程，执行回调
+                // 不过TcpConnection是属于某个subloop，一个subloop属于一个thread，
+                // 能够调用到TcpConnection::handleWrite应该loop_就在自己的thread
+                loop_->queueInloop(std::bind(writeCompleteCallback_, shared_from_this()));
+            }
+
+            if (pausedByHighWaterMark_) {
+                startReadInLoop(); // 积压的数据发送完了，恢复自动暂停的读取
+            }
+
+            if (state_ == kDisconnecting) {
+                // TcpConnection状态是正在关闭，写完这一轮数据就关闭连接
+                shutdownInLoop();
+            }
         }
-    } else { // Channel不可写
-        LOG_ERROR("TcpConnection fd = %d is down, no more writing\n", channel_->fd());
+    } else if (n == 0) {
+        // 只有sendfile会返回0，说明文件比sendFile指定的长度短，数据再也发不完了
+        LOG_ERROR("TcpConnection::handleWrite error\n");
+        handleClose();
+    } else if (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK) {
+        errno = savedErrno;
+        LOG_ERROR("TcpConnection::handleWrite error\n");
     }
 }
 
@@ -260,6 +669,8 @@ void TcpConnection::handleClose()
     LOG_INFO("TcpConnection::handleClose fd = %d state = %d\n", channel_->fd(), (int)state_);
     setState(kDisconnected);
     channel_->disableAll(); // Channel对任何事件不感兴趣并从Poller中删除
+    outputBuffer_.clear(); // 丢弃没发送的数据，没发送完的文件回调失败
+    updatePendingBytes();
 
     TcpConnectionPtr connPtr(shared_from_this()); // connPtr指向当前TcpConnection对象的指针
     connectionCallback_(connPtr); // 执行连接关闭的回调
@@ -268,6 +679,10 @@ void TcpConnection::handleClose()
 
 void TcpConnection::handleError()
 {
+    // MSG_ZEROCOPY的完成通知也是通过EPOLLERR通知的，读完之后socket没有真正的错误就直接返回
+    // setZeroCopy(false)之后错误队列中仍可能有完成通知，不读空的话LT模式下EPOLLERR会一直触发
+    bool zeroCopyCompletions = zeroCopySocket_ && readZeroCopyCompletions();
+
     int optval;
     socklen_t optlen = static_cast<socklen_t>(sizeof optval);
     int err = 0;
@@ -278,5 +693,8 @@ void TcpConnection::handleError()
         err = optval;
     }
 
+    if (zeroCopyCompletions && err == 0) {
+        return;
+    }
     LOG_ERROR("TcpConnection::handleError name: %s - SO_ERROR: %d\n", name_.c_str(), err);
 }
\ No newline at end of file
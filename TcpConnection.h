@@ -4,6 +4,7 @@
 #pragma once
 #include "Buffer.h"
 #include "Callbacks.h"
+#include "ChainBuffer.h"
 #include "InetAddress.h"
 #include "Timestamp.h"
 #include "noncopyable.h"
@@ -42,18 +43,69 @@ public:
     bool connected() const { return state_ == kConnected; }
     bool disconnected() const { return state_ == kDisconnected; }
 
-    void send(const std::string& buf); // 发送数据
-    void send(Buffer* buf); // 发送数据
+    // 发送数据 以下都可以在任意线程调用，不在loop线程时数据的所有权随任务一起移交给loop线程，
+    // 调用返回后调用者可以立即修改或释放传入的数据
+    void send(const std::string& buf); // 不在loop线程时拷贝一次
+    void send(std::string&& buf); // 接管string的内存，发送缓冲区积压时直接作为一段挂在outputBuffer_上，不拷贝
+    void send(Buffer* buf); // 发送buf中的可读数据并清空buf
+    void send(Buffer&& buf); // 接管Buffer的内存
+    // 发送多个连接共享的只读数据[offset, offset + len)，例如广播消息，积压时只增加引用计数
+    void send(const std::shared_ptr<const std::string>& buf, size_t offset, size_t len);
+    void send(const std::shared_ptr<const std::string>& buf) { send(buf, 0, buf->size()); }
+    // 零拷贝发送文件fd中[offset, offset + length)的区域，用sendfile从page cache直接发送到socket，
+    // 排在之前send的数据之后，与send的数据保持先后顺序，待发送的文件字节同样计入高水位
+    // 库不会关闭fd，调用者需要保证fd在cb回调之前一直有效，cb在发送完成或连接断开时调用一次
+    void sendFile(int fd, off_t offset, size_t length, const SendFileCompleteCallback& cb = SendFileCompleteCallback());
     void shutdown(); // 关闭连接
 
+    // 开始/停止读取，即注册/注销EPOLLIN，可以在任意线程调用，停止读取时对端的数据留在内核缓冲区中，
+    // TCP流量控制会让对端减慢发送，用于代理等场景在下游发送缓冲区积压时对上游施加反压
+    void startRead();
+    void stopRead();
+    bool isReading() const { return reading_; } // 不是线程安全的，只在loop线程中读取
+
     void setConnectionCallback(const ConnectionCallback& cb) { connectionCallback_ = cb; }
     void setMessageCallback(const MessageCallback& cb) { messageCallback_ = cb; }
     void setWriteCompleteCallback(const WriteCompleteCallback& cb) { writeCompleteCallback_ = cb; }
     void setHighWaterMarkCallback(const HighWaterMarkCallback& cb) { highWaterMarkCallback_ = cb; }
+    void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
+    {
+        highWaterMarkCallback_ = cb;
+        hightWaterMark_ = highWaterMark;
+    }
+    void setHighWaterMark(size_t highWaterMark) { hightWaterMark_ = highWaterMark; }
+    // 自动反压 outputBuffer_超过高水位时停止读取，数据全部发送完后恢复读取，适合echo这类回复量与请求量相当的服务
+    void setPauseReadOnHighWaterMark(bool on) { pauseReadOnHighWaterMark_ = on; }
     void setCloseCallback(const CloseCallback& cb) { closeCallback_ = cb; }
 
     void setTcpNoDelay(bool on);
 
+    // 使用EPOLLET边沿触发，只能在connectEstablished之前设置，Poller不支持时退回LT
+    // ET模式下EPOLLOUT一直注册，不会随outputBuffer_是否为空反复epoll_ctl，handleRead一直读到EAGAIN
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    bool edgeTriggered() const { return edgeTriggered_; }
+
+    // 收发缓冲区从loop的BufferPool借内存，数据处理完、发送完就归还，默认开启，只能在connectEstablished之前设置
+    // 关闭后inputBuffer_一直持有内存，outputBuffer_自己缓存少量空闲内存块
+    void setUseBufferPool(bool on) { useBufferPool_ = on; }
+
+    // inputBuffer_的收缩策略，见Buffer::setShrinkPolicy，只能在loop线程中调用，threshold为0表示不收缩
+    // 默认容量超过kShrinkThreshold，且连续kShrinkAfterReads次读事件处理完后剩余数据不超过kShrinkLowWaterMark时收缩
+    void setInputBufferShrinkPolicy(size_t threshold, size_t lowWaterMark, int reads)
+    {
+        inputBuffer_.setShrinkPolicy(threshold, lowWaterMark, reads);
+    }
+    // 不小于threshold字节的std::string&&和共享string的发送使用MSG_ZEROCOPY，内核直接引用string的内存，
+    // 不拷贝到socket缓冲区，string在内核通过错误队列发来完成通知之后才释放，只能在loop线程中调用
+    // 内核退化为拷贝时(例如发往loopback)反而更慢，见example/zerocopy
+    void setZeroCopy(bool on, size_t threshold = kDefaultZeroCopyThreshold);
+    bool zeroCopy() const { return zeroCopy_; }
+    const ChainBuffer::ZeroCopyStats& zeroCopyStats() const { return outputBuffer_.zeroCopyStats(); }
+
+    // inputBuffer_是否自适应地预留读取空间，见Buffer::setAdaptiveRead，只能在loop线程中调用
+    void setAdaptiveRead(bool on) { inputBuffer_.setAdaptiveRead(on); }
+    const Buffer& inputBuffer() const { return inputBuffer_; }
+
     void connectEstablished(); // 建立连接
     void connectDestroyed(); // 销毁连接
 
@@ -64,7 +116,13 @@ public:
     const std::any& getContext() const { return context_; }
     std::any* getMutableContext() { return &context_; }
 
+    static const size_t kDefaultZeroCopyThreshold = 64 * 1024;
+
 private:
+    static const size_t kShrinkThreshold = 64 * 1024;
+    static const size_t kShrinkLowWaterMark = 16 * 1024;
+    static const int kShrinkAfterReads = 8;
+
     enum StateE {
         kDisconnected,
         kConnecting,
@@ -79,14 +137,35 @@ private:
     void handleClose();
     void handleError();
 
+    // 是否有待发送的数据在等待EPOLLOUT LT模式下看是否注册了EPOLLOUT，ET模式下看outputBuffer_
+    bool isWriting() const;
+    // outputBuffer_长度变化后把差值同步到loop_的pendingBytes统计
+    void updatePendingBytes();
+
     void sendInLoop(const void* data, size_t len);
+    void sendInLoop(std::string& buf); // 可以移走buf的内存
+    void sendInLoop(const std::shared_ptr<const std::string>& buf, size_t offset, size_t len);
+    void sendZeroCopyInLoop(const std::shared_ptr<const std::string>& buf, size_t offset, size_t len);
+    // 读取socket错误队列中MSG_ZEROCOPY的完成通知，读到了通知返回true
+    bool readZeroCopyCompletions();
+    // outputBuffer_为空时直接write，返回写出的字节数，对端已关闭时置faultError
+    size_t writeDirectly(const char* data, size_t len, bool* faultError);
+    // 剩余数据追加到outputBuffer_之后调用，检查高水位并注册EPOLLOUT
+    void afterAppendOutput(size_t oldLen, size_t added);
+    void sendFileInLoop(int fd, off_t offset, size_t length, const SendFileCompleteCallback& cb);
     void shutdownInLoop();
+    void startReadInLoop();
+    void stopReadInLoop();
+    // outputBuffer_积压到oldLen + added字节后，检查是否越过高水位
+    void checkHighWaterMark(size_t oldLen, size_t added);
+    // inputBuffer_中没有未处理的数据时把内存还给BufferPool
+    void releaseIdleInputBuffer();
     void forceCloseInLoop();
 
     EventLoop* loop_; // 这里不是baseloop，因为TcpConnection都在subloop中管理
     const std::string name_;
     std::atomic_int state_;
-    bool reading_;
+    bool reading_; // 是否注册了EPOLLIN
 
     std::unique_ptr<Socket> socket_;
     std::unique_ptr<Channel> channel_;
@@ -102,7 +181,15 @@ private:
 
     size_t hightWaterMark_;
     Buffer inputBuffer_; // 接收数据的缓冲区
-    Buffer outputBuffer_; // 发送数据的缓冲区
+    ChainBuffer outputBuffer_; // 发送数据的缓冲区，分段保存，追加时不搬移已有数据
+    size_t reportedPendingBytes_; // 上一次同步到loop_的outputBuffer_长度
+    bool edgeTriggered_;
+    bool pauseReadOnHighWaterMark_;
+    bool pausedByHighWaterMark_; // 当前是因为高水位被自动停止读取的
+    bool useBufferPool_;
+    bool zeroCopy_; // 之后的大块发送是否使用MSG_ZEROCOPY
+    bool zeroCopySocket_; // socket上曾经开启过SO_ZEROCOPY，错误队列中可能有完成通知
+    size_t zeroCopyThreshold_;
 
     std::any context_;
 };
@@ -1,10 +1,12 @@
 #include "TcpServer.h"
+#include "BufferPool.h"
 #include "Logger.h"
 #include "Socket.h"
 #include "TcpConnection.h"
 
 #include <cstdio>
 #include <functional>
+#include <future>
 #include <netinet/in.h>
 #include <string>
 #include <strings.h>
@@ -24,16 +26,27 @@ TcpServer::TcpServer(EventLoop* loop, const InetAddress& listenAddr, const std::
     : loop_(CheckLoopNotNull(loop))
     , ipPort_(listenAddr.toIpPort())
     , name_(nameArg)
-    , acceptor_(new Acceptor(loop, listenAddr, option == kReusePort))
+    , listenAddr_(listenAddr)
+    , option_(option)
     , threadPool_(new EventLoopThreadPool(loop, name_))
     , connectionCallback_(defaultConnectionCallback)
     , messageCallback_(defaultMessageCallback)
-    , nextConnId_(1)
+    , acceptBatch_(Acceptor::kDefaultAcceptBatch)
+    , edgeTriggered_(false)
+    , useBufferPool_(true)
+    , bufferPoolMaxBytes_(BufferPool::kDefaultMaxPooledBytes)
+    , zeroCopy_(false)
+    , zeroCopyThreshold_(TcpConnection::kDefaultZeroCopyThreshold)
     , started_(0)
+    , nextConnId_(1)
 {
-    // 有新用户连接时，执行TcpServer::newConnection回调
-    acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this,
-        std::placeholders::_1, std::placeholders::_2));
+    // kReusePortPerLoop模式的Acceptor要等线程池启动后才知道有哪些loop，在start中创建
+    if (option_ != kReusePortPerLoop) {
+        acceptor_.reset(new Acceptor(loop, listenAddr, option == kReusePort));
+        // 有新用户连接时，执行TcpServer::newConnection回调
+        acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this,
+            std::placeholders::_1, std::placeholders::_2));
+    }
 }
 
 TcpServer::~TcpServer()
@@ -50,6 +63,17 @@ TcpServer::~TcpServer()
         // 销毁连接
         conn->getLoop()->runInloop(std::bind(&TcpConnection::connectDestroyed, conn));
     }
+
+    // LoopAcceptor只能在自己的loop中销毁，等待销毁完成，之后它的Acceptor不会再回调TcpServer
+    for (auto& loopAcceptor : loopAcceptors_) {
+        std::promise<void> done;
+        LoopAcceptor* la = loopAcceptor.get();
+        la->loop->runInloop([this, la, &done] {
+            destroyLoopAcceptor(la);
+            done.set_value();
+        });
+        done.get_future().wait();
+    }
 }
 
 // 设置subloop个数
@@ -58,46 +82,105 @@ void TcpServer::setThreadNum(int numThreads)
     threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setLoadBalance(LoadBalanceStrategy::Type type)
+{
+    threadPool_->setStrategy(LoadBalanceStrategy::newStrategy(type));
+}
+
+void TcpServer::setLoadBalanceStrategy(std::unique_ptr<LoadBalanceStrategy> strategy)
+{
+    threadPool_->setStrategy(std::move(strategy));
+}
+
+void TcpServer::setAcceptBatch(int batch)
+{
+    acceptBatch_ = batch;
+    if (acceptor_) {
+        acceptor_->setAcceptBatch(batch);
+    }
+}
+
+AcceptStats TcpServer::acceptStats() const
+{
+    if (acceptor_) {
+        return acceptor_->stats();
+    }
+
+    AcceptStats total;
+    for (const auto& la : loopAcceptors_) {
+        if (!la->acceptor) {
+            continue;
+        }
+        AcceptStats stats = la->acceptor->stats();
+        total.accepted += stats.accepted;
+        total.failed += stats.failed;
+        total.rejected += stats.rejected;
+    }
+    return total;
+}
+
 // 开启服务器监听
 void TcpServer::start()
 {
     if (started_++ == 0) { // started_原子操作，防止TcpServer对象start被创建多次
         threadPool_->start(threadInitCallback_); // 启动底层loop线程池
-        loop_->runInloop(std::bind(&Acceptor::listen, acceptor_.get()));
+        for (EventLoop* ioloop : threadPool_->getAllLoops()) {
+            ioloop->bufferPool()->setMaxPooledBytes(bufferPoolMaxBytes_);
+        }
+
+        if (option_ == kReusePortPerLoop) {
+            // 没有设置线程数时getAllLoops返回baseloop，只有一个Acceptor
+            for (EventLoop* ioloop : threadPool_->getAllLoops()) {
+                LoopAcceptor* la = new LoopAcceptor;
+                la->loop = ioloop;
+                la->acceptor.reset(new Acceptor(ioloop, listenAddr_, true));
+                la->acceptor->setAcceptBatch(acceptBatch_);
+                la->acceptor->setNewConnectionCallback(std::bind(&TcpServer::newConnectionInLoop, this,
+                    la, std::placeholders::_1, std::placeholders::_2));
+                loopAcceptors_.push_back(std::unique_ptr<LoopAcceptor>(la));
+                ioloop->runInloop(std::bind(&Acceptor::listen, la->acceptor.get()));
+            }
+        } else {
+            loop_->runInloop(std::bind(&Acceptor::listen, acceptor_.get()));
+        }
     }
 }
 
-// 有新客户端连接，acceptor会执行这个回调
-void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
+TcpConnectionPtr TcpServer::createConnection(EventLoop* ioloop, int sockfd, const InetAddress& peerAddr)
 {
-    // 通过线程池的轮询算法选择一个subloop来管理这个Channel
-    EventLoop* ioloop = threadPool_->getNextLoop();
-
     char buf[64] = { 0 };
-    snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_);
-    ++nextConnId_; // ConnId只在mainloop中++，没有线程安全问题
+    snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_++);
     std::string connName = name_ + buf;
     LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s\n",
         name_.c_str(), connName.c_str(), peerAddr.toIpPort().c_str());
 
     // 通过sockfd获取其绑定的本机ip地址和端口号
-    // sockaddr_in localaddr;
-    // ::bzero(&localaddr, sizeof localaddr);
-    // socklen_t addrlen = static_cast<socklen_t>(sizeof localaddr);
-    // if (::getsockname(sockfd, (sockaddr*)&localaddr, &addrlen) < 0) {
-    //     LOG_ERROR("sockets::getLoaclAddr\n");
-    // }
     InetAddress localAddr(Socket::getLocalAddr(sockfd));
 
     // 根据连接成功的sockfd，创建TcpConnection对象  localAddr--服务器 peerAddr--客户端
     TcpConnectionPtr conn(new TcpConnection(
         ioloop, connName, sockfd, localAddr, peerAddr));
-    connections_[connName] = conn;
 
     // 下面的回调都是用户设置给TcpServer=>TcpConnection=>Channel=>注册到Poller=>notify Channel执行回调
     conn->setConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleteCallback(writeCompleteCallback_);
+    conn->setEdgeTriggered(edgeTriggered_);
+    conn->setUseBufferPool(useBufferPool_);
+    if (zeroCopy_) {
+        conn->setZeroCopy(true, zeroCopyThreshold_);
+    }
+    return conn;
+}
+
+// 有新客户端连接，acceptor会执行这个回调
+void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
+{
+    // 通过线程池的负载均衡策略选择一个subloop来管理这个Channel，默认轮询
+    EventLoop* ioloop = threadPool_->getLoopForConnection(peerAddr);
+
+    TcpConnectionPtr conn(createConnection(ioloop, sockfd, peerAddr));
+    connections_[conn->name()] = conn;
 
     // 设置了如何关闭连接的回调 TcpServer::removeConnection
     conn->setCloseCallback(std::bind(&TcpServer::removeConnection, this, std::placeholders::_1));
@@ -118,4 +201,37 @@ void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
     connections_.erase(conn->name());
     EventLoop* ioLoop = conn->getLoop();
     ioLoop->queueInloop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+// kReusePortPerLoop模式 Acceptor就运行在连接所属的loop中，不需要跨线程
+void TcpServer::newConnectionInLoop(LoopAcceptor* loopAcceptor, int sockfd, const InetAddress& peerAddr)
+{
+    TcpConnectionPtr conn(createConnection(loopAcceptor->loop, sockfd, peerAddr));
+    loopAcceptor->connections[conn->name()] = conn;
+
+    conn->setCloseCallback(std::bind(&TcpServer::removeConnectionFromLoop, this,
+        loopAcceptor, std::placeholders::_1));
+    conn->connectEstablished();
+}
+
+void TcpServer::removeConnectionFromLoop(LoopAcceptor* loopAcceptor, const TcpConnectionPtr& conn)
+{
+    LOG_INFO("TcpServer::removeConnectionFromLoop [%s] - connection %s\n",
+        name_.c_str(), conn->name().c_str());
+
+    loopAcceptor->connections.erase(conn->name());
+    // 还在TcpConnection::handleClose中，connectDestroyed要等它返回后再执行
+    loopAcceptor->loop->queueInloop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+void TcpServer::destroyLoopAcceptor(LoopAcceptor* loopAcceptor)
+{
+    loopAcceptor->acceptor.reset(); // 关闭监听socket
+
+    for (auto& item : loopAcceptor->connections) {
+        TcpConnectionPtr conn(item.second);
+        item.second.reset();
+        conn->connectDestroyed();
+    }
+    loopAcceptor->connections.clear();
 }
\ No newline at end of file
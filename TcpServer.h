@@ -8,6 +8,7 @@
 #include "EventLoop.h"
 #include "EventLoopThreadPool.h"
 #include "InetAddress.h"
+#include "LoadBalanceStrategy.h"
 #include "Logger.h"
 #include "TcpConnection.h"
 #include "noncopyable.h"
@@ -17,6 +18,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 // 对外服务器编程使用的类
 class TcpServer {
@@ -26,6 +28,9 @@ public:
     enum Option {
         kNoReusePort,
         kReusePort,
+        // 每个subloop各自创建一个设置了SO_REUSEPORT的Acceptor监听同一个端口，
+        // 由内核在多个监听socket之间分配新连接，accept和连接的整个生命周期都在同一个loop中，不再经过mainloop
+        kReusePortPerLoop,
     };
 
     TcpServer(EventLoop* loop, const InetAddress& listenAddr, const std::string& nameArg, Option option = kNoReusePort);
@@ -44,22 +49,64 @@ public:
     void setMessageCallback(const MessageCallback& cb) { messageCallback_ = cb; }
     void setWriteCompleteCallback(const WriteCompleteCallback& cb) { writeCompleteCallback_ = cb; }
 
+    // 新连接分配subloop的负载均衡策略，默认轮询，kReusePortPerLoop模式下由内核分配，不使用策略
+    void setLoadBalance(LoadBalanceStrategy::Type type);
+    void setLoadBalanceStrategy(std::unique_ptr<LoadBalanceStrategy> strategy);
+
+    // 新连接使用EPOLLET边沿触发，适合写多、经常被慢速对端阻塞的连接，在start之前设置
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+
+    // 连接的收发缓冲区是否从每个loop的BufferPool借内存，默认开启，空闲连接不持有缓冲区内存，在start之前设置
+    void setUseBufferPool(bool on) { useBufferPool_ = on; }
+    // 每个loop的BufferPool最多缓存的字节数，在start之前设置
+    void setBufferPoolMaxBytes(size_t maxBytes) { bufferPoolMaxBytes_ = maxBytes; }
+
+    // 新连接不小于threshold字节的std::string&&和共享string用MSG_ZEROCOPY发送，在start之前设置
+    void setZeroCopy(bool on, size_t threshold = TcpConnection::kDefaultZeroCopyThreshold)
+    {
+        zeroCopy_ = on;
+        zeroCopyThreshold_ = threshold;
+    }
+
+    // 每次listenfd可读时最多accept的连接数，在start之前设置
+    void setAcceptBatch(int batch);
+    // 所有Acceptor的accept统计之和，可以在任意线程调用
+    AcceptStats acceptStats() const;
+
     // 开启服务器监听
     void start();
 
 private:
+    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+
+    // kReusePortPerLoop模式下一个loop的监听socket和它接受的连接，只在该loop线程中访问
+    struct LoopAcceptor {
+        EventLoop* loop;
+        std::unique_ptr<Acceptor> acceptor;
+        ConnectionMap connections;
+    };
+
     void newConnection(int sockfd, const InetAddress& peerAddr);
     void removeConnection(const TcpConnectionPtr& conn);
     void removeConnectionInLoop(const TcpConnectionPtr& conn);
 
-    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+    // kReusePortPerLoop模式下的新连接和连接关闭，都在loopAcceptor->loop中执行
+    void newConnectionInLoop(LoopAcceptor* loopAcceptor, int sockfd, const InetAddress& peerAddr);
+    void removeConnectionFromLoop(LoopAcceptor* loopAcceptor, const TcpConnectionPtr& conn);
+    void destroyLoopAcceptor(LoopAcceptor* loopAcceptor);
+
+    // 创建TcpConnection并设置回调
+    TcpConnectionPtr createConnection(EventLoop* ioloop, int sockfd, const InetAddress& peerAddr);
 
     EventLoop* loop_; // baseloop用户定义
 
     const std::string ipPort_;
     const std::string name_;
+    const InetAddress listenAddr_;
+    const Option option_;
 
-    std::unique_ptr<Acceptor> acceptor_; // 运行在mainloop，任务就是监听新连接
+    std::unique_ptr<Acceptor> acceptor_; // 运行在mainloop，任务就是监听新连接，kReusePortPerLoop模式下为空
+    std::vector<std::unique_ptr<LoopAcceptor>> loopAcceptors_; // kReusePortPerLoop模式下每个loop一个
 
     std::shared_ptr<EventLoopThreadPool> threadPool_; // one loop per thread
 
@@ -69,10 +116,16 @@ private:
 
     ThreadInitCallback threadInitCallback_; // loop线程初始化的回调
 
+    int acceptBatch_;
+    bool edgeTriggered_;
+    bool useBufferPool_;
+    size_t bufferPoolMaxBytes_;
+    bool zeroCopy_;
+    size_t zeroCopyThreshold_;
     std::atomic_int started_;
 
-    int nextConnId_;
-    ConnectionMap connections_; // 保存所有的连接
+    std::atomic_int nextConnId_; // kReusePortPerLoop模式下多个loop同时生成连接名
+    ConnectionMap connections_; // 保存所有的连接，kReusePortPerLoop模式下保存在各自的LoopAcceptor中
 };
 
 #endif
\ No newline at end of file
@@ -7,25 +7,39 @@
 class Timer;
 
 // 封装一个Timer和其序列号，并且将TimerQueue设置为友元
+// 时间轮中的粗粒度定时器没有Timer对象，用时间轮中的下标wheelIndex_和序列号标识
 class TimerId {
 public:
     TimerId()
         : timer_(nullptr)
         , sequence_(0)
+        , wheelIndex_(-1)
     {
     }
     TimerId(Timer* timer, int64_t seq)
         : timer_(timer)
         , sequence_(seq)
+        , wheelIndex_(-1)
     {
     }
+    TimerId(Timer* timer, int64_t seq, int wheelIndex)
+        : timer_(timer)
+        , sequence_(seq)
+        , wheelIndex_(wheelIndex)
+    {
+    }
+
+    // 是否是时间轮中的定时器
+    bool isCoarse() const { return wheelIndex_ >= 0; }
 
-    // 把TimerQueue设置为友元
+    // 把TimerQueue和TimingWheel设置为友元
     friend class TimerQueue;
+    friend class TimingWheel;
 
 private:
     Timer* timer_;
     int64_t sequence_;
+    int wheelIndex_;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -81,10 +81,11 @@ TimerQueue::TimerQueue(EventLoop* loop)
     , timerfd_(createTimerfd())
     , timerfdChannel_(loop, timerfd_) // timerfd_封装成Channel
     , timers_()
+    , wheel_(Timestamp::now())
     , callingExpiredTimers_(false)
 {
     // 绑定timerfdChannel_的回调函数是TimerQueue::handleRead
-    timerfdChannel_.setReadCallBack(std::bind(&TimerQueue::handleRead, this));
+    timerfdChannel_.setReadCallBack(std::bind(&TimerQueue::handleRead, this, std::placeholders::_1));
     // 因为我们只会对timerfd的读事件感兴趣，将超时的timer读取出来，所以开启读事件监听并且添加到Poller中
     timerfdChannel_.enableReading();
 }
@@ -112,10 +113,46 @@ void TimerQueue::addTimerInLoop(Timer* timer)
     bool earliestChanged = insert(timer);
     if (earliestChanged) {
         // 如果新加入的定时器是最早执行的，需要修改timerfd的定时时间
-        resetTimerfd(timerfd_, timer->expiration());
+        scheduleTimerfd(timer->expiration());
     }
 }
 
+TimerId TimerQueue::addCoarseTimer(TimerCallback cb, double delay)
+{
+    TimerId timerId = wheel_.add(std::move(cb), delay, coarseNow());
+    scheduleTimerfd(wheel_.expirationOf(timerId));
+    return timerId;
+}
+
+void TimerQueue::touch(TimerId timerId)
+{
+    loop_->runInloop(std::bind(&TimerQueue::touchInLoop, this, timerId));
+}
+
+// 刷新只会推迟到期时间，timerfd不需要修改
+// 已到期还没执行回调的定时器刷新后会重新挂到时间轮上，这时需要检查timerfd
+void TimerQueue::touchInLoop(TimerId timerId)
+{
+    if (wheel_.touch(timerId, coarseNow())) {
+        scheduleTimerfd(wheel_.expirationOf(timerId));
+    }
+}
+
+void TimerQueue::scheduleTimerfd(Timestamp when)
+{
+    if (when.valid() && (!timerfdExpiration_.valid() || when < timerfdExpiration_)) {
+        timerfdExpiration_ = when;
+        resetTimerfd(timerfd_, when);
+    }
+}
+
+// 频繁调用的刷新操作使用poll返回时缓存的时间，时间轮的精度远大于这个误差
+Timestamp TimerQueue::coarseNow() const
+{
+    Timestamp now = loop_->pollReturnTime();
+    return now.valid() ? now : Timestamp::now();
+}
+
 void TimerQueue::cancel(TimerId timerId)
 {
     loop_->runInloop(std::bind(&TimerQueue::cancelInLoop, this, timerId));
@@ -123,6 +160,11 @@ void TimerQueue::cancel(TimerId timerId)
 
 void TimerQueue::cancelInLoop(TimerId timerId)
 {
+    if (timerId.isCoarse()) {
+        wheel_.cancel(timerId);
+        return;
+    }
+
     // 通过timerId构建ActiveTimer对象，并在ActiveTimerSet中查找
     ActiveTimer timer(timerId.timer_, timerId.sequence_);
     ActiveTimerSet::iterator it = activeTimers_.find(timer);
@@ -139,10 +181,12 @@ void TimerQueue::cancelInLoop(TimerId timerId)
 
 // timerfd有读事件到来回调这个函数
 // 处理timerfd，并运行超时的定时器超时处理函数
-void TimerQueue::handleRead()
+// 直接使用poll返回时缓存的时间判断是否超时，不再重复获取当前时间
+void TimerQueue::handleRead(Timestamp receiveTime)
 {
-    Timestamp now(Timestamp::now());
+    Timestamp now(receiveTime);
     readTimerfd(timerfd_, now);
+    timerfdExpiration_ = Timestamp::invalid(); // timerfd已经触发，需要重新设置
 
     // 获取超时的timer
     std::vector<Entry> expired = getExpired(now);
@@ -158,6 +202,10 @@ void TimerQueue::handleRead()
     // 重置上面调用timer的定时任务
     // 循环执行还要设置下一次执行时间
     reset(expired, now);
+
+    // 处理时间轮中到期的粗粒度定时器，并按下一个非空的tick设置timerfd
+    wheel_.advance(now);
+    scheduleTimerfd(wheel_.nextExpiration());
 }
 
 // 获取所有超时的定时器
@@ -230,8 +278,6 @@ void TimerQueue::reset(const std::vector<Entry>& expired, Timestamp now)
         nextExpire = timers_.begin()->second->expiration();
     }
 
-    if (nextExpire.valid()) {
-        // 重置timerfd_的超时时间
-        resetTimerfd(timerfd_, nextExpire);
-    }
+    // 重置timerfd_的超时时间
+    scheduleTimerfd(nextExpire);
 }
\ No newline at end of file
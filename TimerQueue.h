@@ -4,6 +4,7 @@
 #pragma once
 #include "Callbacks.h"
 #include "Channel.h"
+#include "TimingWheel.h"
 #include "Timestamp.h"
 #include "noncopyable.h"
 
@@ -22,6 +23,7 @@ class TimerId;
 // TimerQueue保存EventLoop中的Timer，根据超时时间从小到大放入集合中
 // 最小的超时时间设置为timerfd的超时时间，到时间后timerfd有读事件发生
 // 回调该Timer的定时处理函数
+// 粗粒度定时器保存在时间轮wheel_中，与Timer共用同一个timerfd
 class TimerQueue : noncopyable {
 public:
     explicit TimerQueue(EventLoop* loop);
@@ -30,6 +32,11 @@ public:
     // 添加定时器 一般在其他线程调用
     TimerId addTimer(TimerCallback cb, Timestamp when, double interval);
 
+    // 向时间轮添加粗粒度定时器 只能在loop线程调用
+    TimerId addCoarseTimer(TimerCallback cb, double delay);
+    // 刷新粗粒度定时器的到期时间
+    void touch(TimerId timerId);
+
     void cancel(TimerId timerId);
 
 private:
@@ -39,10 +46,16 @@ private:
     using ActiveTimerSet = std::set<ActiveTimer>;
 
     void addTimerInLoop(Timer* timer);
+    void touchInLoop(TimerId timerId);
     void cancelInLoop(TimerId timerId);
 
-    // timerfd有读事件到来回调这个函数
-    void handleRead();
+    // timerfd_的超时时间早于when时才修改，保证Timer和时间轮都能按时触发
+    void scheduleTimerfd(Timestamp when);
+    // loop缓存的当前时间，loop还没开始时取当前时间
+    Timestamp coarseNow() const;
+
+    // timerfd有读事件到来回调这个函数 receiveTime是本轮poll返回的时间
+    void handleRead(Timestamp receiveTime);
 
     // 获取所有超时的定时器
     std::vector<Entry> getExpired(Timestamp now);
@@ -54,7 +67,9 @@ private:
     EventLoop* loop_;
     const int timerfd_;
     Channel timerfdChannel_;
+    Timestamp timerfdExpiration_; // timerfd_当前设置的超时时间，已触发时为invalid
     TimerList timers_; // 存储定时器和超时时间的表
+    TimingWheel wheel_; // 粗粒度定时器
 
     ActiveTimerSet activeTimers_;
     std::atomic_bool callingExpiredTimers_;
@@ -13,22 +13,30 @@ Timestamp::Timestamp(int64_t microSecondsSinceEpoch)
 {
 }
 
+// clock_gettime通过vDSO实现，不会陷入内核，精度为纳秒，这里保留到微秒
 Timestamp Timestamp::now()
 {
-    return Timestamp(time(NULL));
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return Timestamp(static_cast<int64_t>(ts.tv_sec) * kMicroSecondsPerSecond + ts.tv_nsec / 1000);
 }
 
+// 格式 2023-10-01 12:00:00.123456
 std::string Timestamp::toString() const
 {
     char buf[128] = { 0 };
-    tm* tm_time = localtime(&microSecondsSinceEpoch_);
-    snprintf(buf, 128, "%4d-%02d-%02d %02d:%02d:%02d",
-        tm_time->tm_year + 1900,
-        tm_time->tm_mon + 1,
-        tm_time->tm_mday,
-        tm_time->tm_hour,
-        tm_time->tm_min,
-        tm_time->tm_sec);
+    time_t seconds = static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond);
+    int microseconds = static_cast<int>(microSecondsSinceEpoch_ % kMicroSecondsPerSecond);
+    struct tm tm_time;
+    localtime_r(&seconds, &tm_time); // localtime返回静态变量，多线程下不安全
+    snprintf(buf, 128, "%4d-%02d-%02d %02d:%02d:%02d.%06d",
+        tm_time.tm_year + 1900,
+        tm_time.tm_mon + 1,
+        tm_time.tm_mday,
+        tm_time.tm_hour,
+        tm_time.tm_min,
+        tm_time.tm_sec,
+        microseconds);
     return buf;
 }
 
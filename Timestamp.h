@@ -5,7 +5,7 @@
 #include <cstdint>
 #include <string>
 
-// 时间戳类，用于获取当前时间
+// 时间戳类，用于获取当前时间，精度为微秒
 class Timestamp {
 public:
     Timestamp();
@@ -29,6 +29,13 @@ private:
     int64_t microSecondsSinceEpoch_;
 };
 
+// 返回两个时间点的差值，单位为s
+inline double timeDifference(Timestamp high, Timestamp low)
+{
+    int64_t diff = high.microSecondsSinceEpoch() - low.microSecondsSinceEpoch();
+    return static_cast<double>(diff) / Timestamp::kMicroSecondsPerSecond;
+}
+
 inline Timestamp addTime(Timestamp timestamp, double seconds)
 {
     int64_t delta = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
@@ -0,0 +1,238 @@
+#include "TimingWheel.h"
+
+#include <algorithm>
+#include <utility>
+
+const int64_t TimingWheel::kDefaultTickMicroSeconds;
+const size_t TimingWheel::kDefaultSlots;
+
+// 槽数向上取整为2的幂
+static size_t roundUpPowerOfTwo(size_t n)
+{
+    size_t size = 1;
+    while (size < n) {
+        size <<= 1;
+    }
+    return size;
+}
+
+TimingWheel::TimingWheel(Timestamp now, int64_t tickMicroSeconds, size_t numSlots)
+    : tickMicroSeconds_(tickMicroSeconds)
+    , mask_(roundUpPowerOfTwo(numSlots) - 1)
+    , currentTick_(now.microSecondsSinceEpoch() / tickMicroSeconds)
+    , size_(0)
+    , slots_(mask_ + 1, -1)
+    , freeList_(-1)
+    , nextSequence_(0)
+{
+}
+
+// 添加delay秒后到期的定时器
+// 到期tick向上取整，保证定时器不会提前执行
+TimerId TimingWheel::add(TimerCallback cb, double delay, Timestamp now)
+{
+    if (size_ == 0) {
+        // 时间轮为空时没有需要处理的槽，直接跳到当前tick
+        currentTick_ = std::max(currentTick_, tickOf(now));
+    }
+
+    int index = allocEntry();
+    Entry& entry = entries_[index];
+    entry.callback = std::move(cb);
+    entry.delayMicroSeconds = std::max<int64_t>(static_cast<int64_t>(delay * Timestamp::kMicroSecondsPerSecond), 0);
+
+    int64_t expireTick = (now.microSecondsSinceEpoch() + entry.delayMicroSeconds + tickMicroSeconds_ - 1) / tickMicroSeconds_;
+    link(index, std::max(expireTick, currentTick_ + 1));
+    ++size_;
+
+    return TimerId(nullptr, entry.sequence, index);
+}
+
+// 把定时器的到期时间刷新为now + delay
+bool TimingWheel::touch(TimerId timerId, Timestamp now)
+{
+    Entry* entry = find(timerId);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    int64_t expireTick = (now.microSecondsSinceEpoch() + entry->delayMicroSeconds + tickMicroSeconds_ - 1) / tickMicroSeconds_;
+    expireTick = std::max(expireTick, currentTick_ + 1);
+
+    if (entry->state == kLinked && expireTick >= entry->expireTick) {
+        // 到期时间只会往后推，节点留在原来的槽上，轮到该槽时再移动
+        entry->expireTick = expireTick;
+    } else {
+        // 时钟回拨，或者定时器已经到期还没执行回调，重新挂到对应的槽上
+        if (entry->state == kLinked) {
+            unlink(timerId.wheelIndex_);
+        } else {
+            ++size_;
+        }
+        link(timerId.wheelIndex_, expireTick);
+    }
+    return true;
+}
+
+void TimingWheel::cancel(TimerId timerId)
+{
+    Entry* entry = find(timerId);
+    if (entry == nullptr) {
+        return;
+    }
+
+    if (entry->state == kLinked) {
+        unlink(timerId.wheelIndex_);
+        --size_;
+    }
+    // kFiring状态的节点释放后，advance中检查状态不会再执行它的回调
+    freeEntry(timerId.wheelIndex_);
+}
+
+// 处理now之前所有到期的tick，执行到期定时器的回调
+void TimingWheel::advance(Timestamp now)
+{
+    int64_t nowTick = tickOf(now);
+    if (nowTick <= currentTick_) {
+        return;
+    }
+
+    // 超过一圈没有处理时，每个槽只需要遍历一次
+    int64_t steps = std::min<int64_t>(nowTick - currentTick_, static_cast<int64_t>(slots_.size()));
+    for (int64_t i = 1; i <= steps; ++i) {
+        size_t slot = static_cast<size_t>(currentTick_ + i) & mask_;
+        int index = slots_[slot];
+        while (index != -1) {
+            Entry& entry = entries_[index];
+            int next = entry.next;
+            if (entry.expireTick <= nowTick) {
+                unlink(index);
+                entry.state = kFiring;
+                --size_;
+                firing_.push_back(index);
+            } else if ((static_cast<size_t>(entry.expireTick) & mask_) != slot) {
+                // touch过的定时器，挂到新的到期tick对应的槽上
+                unlink(index);
+                link(index, entry.expireTick);
+            }
+            index = next;
+        }
+    }
+    currentTick_ = nowTick;
+
+    // 先释放节点再执行回调，回调中可以安全地添加、刷新、取消定时器
+    std::vector<int> firing;
+    firing.swap(firing_);
+    for (int index : firing) {
+        if (entries_[index].state != kFiring) {
+            continue; // 被前面执行的回调取消或刷新了
+        }
+        TimerCallback cb(std::move(entries_[index].callback));
+        freeEntry(index);
+        cb();
+    }
+    firing.clear();
+    firing_.swap(firing); // 保留vector的容量，下次不用重新分配
+}
+
+// 下一个有定时器的tick的时间
+Timestamp TimingWheel::nextExpiration() const
+{
+    if (size_ == 0) {
+        return Timestamp::invalid();
+    }
+
+    for (size_t i = 1; i <= slots_.size(); ++i) {
+        if (slots_[static_cast<size_t>(currentTick_ + i) & mask_] != -1) {
+            return timeOf(currentTick_ + i);
+        }
+    }
+    return Timestamp::invalid();
+}
+
+Timestamp TimingWheel::expirationOf(TimerId timerId) const
+{
+    const Entry* entry = find(timerId);
+    if (entry == nullptr || entry->state != kLinked) {
+        return Timestamp::invalid();
+    }
+    return timeOf(entry->expireTick);
+}
+
+TimingWheel::Entry* TimingWheel::find(TimerId timerId)
+{
+    return const_cast<Entry*>(static_cast<const TimingWheel*>(this)->find(timerId));
+}
+
+const TimingWheel::Entry* TimingWheel::find(TimerId timerId) const
+{
+    int index = timerId.wheelIndex_;
+    if (index < 0 || static_cast<size_t>(index) >= entries_.size()) {
+        return nullptr;
+    }
+
+    const Entry& entry = entries_[index];
+    if (entry.state == kFree || entry.sequence != timerId.sequence_) {
+        return nullptr; // 定时器已到期或已取消，节点可能已经被复用
+    }
+    return &entry;
+}
+
+int TimingWheel::allocEntry()
+{
+    int index = freeList_;
+    if (index != -1) {
+        freeList_ = entries_[index].next;
+    } else {
+        entries_.emplace_back();
+        index = static_cast<int>(entries_.size() - 1);
+    }
+
+    Entry& entry = entries_[index];
+    entry.sequence = ++nextSequence_;
+    entry.prev = -1;
+    entry.next = -1;
+    entry.slot = -1;
+    return index;
+}
+
+void TimingWheel::freeEntry(int index)
+{
+    Entry& entry = entries_[index];
+    entry.callback = nullptr; // 尽早释放回调中捕获的对象
+    entry.state = kFree;
+    entry.next = freeList_;
+    freeList_ = index;
+}
+
+// 把节点挂到tick对应槽的链表头
+void TimingWheel::link(int index, int64_t tick)
+{
+    Entry& entry = entries_[index];
+    size_t slot = static_cast<size_t>(tick) & mask_;
+
+    entry.expireTick = tick;
+    entry.slot = static_cast<int>(slot);
+    entry.state = kLinked;
+    entry.prev = -1;
+    entry.next = slots_[slot];
+    if (entry.next != -1) {
+        entries_[entry.next].prev = index;
+    }
+    slots_[slot] = index;
+}
+
+void TimingWheel::unlink(int index)
+{
+    Entry& entry = entries_[index];
+    if (entry.prev != -1) {
+        entries_[entry.prev].next = entry.next;
+    } else {
+        slots_[entry.slot] = entry.next;
+    }
+    if (entry.next != -1) {
+        entries_[entry.next].prev = entry.prev;
+    }
+    entry.prev = -1;
+    entry.next = -1;
+}
@@ -0,0 +1,91 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#pragma once
+#include "Callbacks.h"
+#include "TimerId.h"
+#include "Timestamp.h"
+#include "noncopyable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// 哈希时间轮，用于连接空闲超时这类数量多、精度要求不高、经常刷新的定时器
+// 时间按tick划分，第n个tick的定时器挂在slots_[n % slots]的双向链表上，
+// 超过一圈的定时器在轮到它所在的槽时再判断是否到期
+// 插入、刷新、取消都是O(1)，刷新只修改到期tick，不移动链表节点，轮到该槽时再挂到新的槽上
+// 所有定时器节点保存在entries_数组中，通过空闲链表复用，不会为每个定时器单独new
+//
+// TimingWheel由TimerQueue持有，与普通定时器共用同一个timerfd，只能在loop线程中使用
+//
+class TimingWheel : noncopyable {
+public:
+    static const int64_t kDefaultTickMicroSeconds = 100 * 1000; // 100ms一个tick
+    static const size_t kDefaultSlots = 4096; // 一圈约410s，常见的空闲超时一圈之内就能到期
+
+    explicit TimingWheel(Timestamp now,
+        int64_t tickMicroSeconds = kDefaultTickMicroSeconds,
+        size_t numSlots = kDefaultSlots);
+
+    // 添加delay秒后到期的定时器
+    TimerId add(TimerCallback cb, double delay, Timestamp now);
+    // 把定时器的到期时间刷新为now + delay，定时器已到期或已取消返回false
+    bool touch(TimerId timerId, Timestamp now);
+    void cancel(TimerId timerId);
+
+    // 处理now之前所有到期的tick，执行到期定时器的回调
+    void advance(Timestamp now);
+
+    // 下一个有定时器的tick的时间，没有定时器时返回invalid
+    Timestamp nextExpiration() const;
+    // 定时器timerId所在tick的时间，用于添加定时器后调整timerfd
+    Timestamp expirationOf(TimerId timerId) const;
+
+    size_t size() const { return size_; }
+
+private:
+    enum EntryState {
+        kFree, // 在空闲链表中
+        kLinked, // 挂在某个槽上
+        kFiring, // 已到期，等待执行回调
+    };
+
+    struct Entry {
+        TimerCallback callback;
+        int64_t expireTick; // 到期的tick
+        int64_t delayMicroSeconds; // touch时按这个间隔刷新
+        int64_t sequence;
+        int prev;
+        int next;
+        int slot;
+        EntryState state;
+    };
+
+    int64_t tickOf(Timestamp when) const { return when.microSecondsSinceEpoch() / tickMicroSeconds_; }
+    Timestamp timeOf(int64_t tick) const { return Timestamp(tick * tickMicroSeconds_); }
+
+    Entry* find(TimerId timerId);
+    const Entry* find(TimerId timerId) const;
+
+    int allocEntry();
+    void freeEntry(int index);
+
+    void link(int index, int64_t tick);
+    void unlink(int index);
+
+    const int64_t tickMicroSeconds_;
+    const size_t mask_; // 槽数是2的幂，用&代替%
+    int64_t currentTick_; // 已经处理到的tick
+    size_t size_; // 未到期的定时器个数
+
+    std::vector<int> slots_; // 每个槽链表头在entries_中的下标，-1表示空
+    std::vector<Entry> entries_;
+    int freeList_; // 空闲链表头
+    int64_t nextSequence_;
+
+    std::vector<int> firing_; // advance中收集的到期定时器
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "UdpServer.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <cstdio>
+#include <future>
+
+UdpServer::UdpServer(EventLoop* loop, const InetAddress& listenAddr, const std::string& nameArg, Option option)
+    : loop_(loop)
+    , name_(nameArg)
+    , listenAddr_(listenAddr)
+    , option_(option)
+    , threadPool_(new EventLoopThreadPool(loop, name_))
+    , batchSize_(UdpSocket::kDefaultBatchSize)
+    , maxDatagramSize_(UdpSocket::kDefaultMaxDatagramSize)
+    , started_(0)
+{
+    if (loop == nullptr) {
+        LOG_FATAL("%s-%s-%d mainLoop is null!\n", __FILE__, __FUNCTION__, __LINE__);
+    }
+}
+
+UdpServer::~UdpServer()
+{
+    LOG_INFO("UdpServer::~UdpServer [%s] destructing\n", name_.c_str());
+
+    // socket只能在自己的loop中注销，等待注销完成，之后不会再回调UdpServer的用户
+    for (const UdpSocketPtr& socket : sockets_) {
+        std::promise<void> done;
+        socket->getLoop()->runInloop([&socket, &done] {
+            socket->stop();
+            done.set_value();
+        });
+        done.get_future().wait();
+    }
+}
+
+void UdpServer::setThreadNum(int numThreads)
+{
+    if (option_ != kReusePortPerLoop && numThreads > 0) {
+        LOG_ERROR("UdpServer::setThreadNum [%s] only kReusePortPerLoop uses subloops\n", name_.c_str());
+    }
+    threadPool_->setThreadNum(numThreads);
+}
+
+UdpStats UdpServer::stats() const
+{
+    UdpStats total;
+    for (const UdpSocketPtr& socket : sockets_) {
+        UdpStats stats = socket->stats();
+        total.received += stats.received;
+        total.receivedBytes += stats.receivedBytes;
+        total.recvCalls += stats.recvCalls;
+        total.sent += stats.sent;
+        total.sentBytes += stats.sentBytes;
+        total.sendCalls += stats.sendCalls;
+        total.truncated += stats.truncated;
+        total.dropped += stats.dropped;
+    }
+    return total;
+}
+
+void UdpServer::start()
+{
+    if (started_++ != 0) {
+        return;
+    }
+
+    std::vector<EventLoop*> loops;
+    if (option_ == kReusePortPerLoop) {
+        threadPool_->start(threadInitCallback_);
+        loops = threadPool_->getAllLoops(); // 没有设置线程数时返回baseloop
+    } else {
+        loops.push_back(loop_);
+    }
+
+    for (size_t i = 0; i < loops.size(); ++i) {
+        char buf[64] = { 0 };
+        snprintf(buf, sizeof buf, "-%s#%zu", listenAddr_.toIpPort().c_str(), i);
+        UdpSocketPtr socket(std::make_shared<UdpSocket>(loops[i], name_ + buf));
+        socket->setBatchSize(batchSize_);
+        socket->setMaxDatagramSize(maxDatagramSize_);
+        socket->setMessageCallback(messageCallback_);
+        socket->bind(listenAddr_, option_ == kReusePortPerLoop);
+        sockets_.push_back(socket);
+        socket->start(); // 在socket所属的loop中注册读事件
+    }
+}
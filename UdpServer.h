@@ -0,0 +1,72 @@
+#ifndef UDPSERVER_H
+#define UDPSERVER_H
+
+#pragma once
+#include "Callbacks.h"
+#include "EventLoopThreadPool.h"
+#include "InetAddress.h"
+#include "UdpSocket.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class EventLoop;
+
+//
+// UDP服务器，没有连接的概念，每个数据报都通过messageCallback交给用户，回复用UdpSocket::sendTo
+// kSingleSocket: 只在baseloop上创建一个socket，所有数据报都在baseloop中处理
+// kReusePortPerLoop: 每个loop(没有设置线程数时只有baseloop)创建一个绑定同一地址的SO_REUSEPORT socket，
+//                    由内核按四元组把数据报分配给各个socket，各个loop之间不需要任何跨线程操作
+//
+class UdpServer : noncopyable {
+public:
+    using ThreadInitCallback = std::function<void(EventLoop*)>;
+
+    enum Option {
+        kSingleSocket,
+        kReusePortPerLoop,
+    };
+
+    UdpServer(EventLoop* loop, const InetAddress& listenAddr, const std::string& nameArg, Option option = kSingleSocket);
+    ~UdpServer();
+
+    const std::string& name() const { return name_; }
+    EventLoop* getLoop() const { return loop_; }
+
+    // 设置subloop个数，只在kReusePortPerLoop模式下有意义
+    void setThreadNum(int numThreads);
+    void setThreadInitCallback(const ThreadInitCallback& cb) { threadInitCallback_ = cb; }
+
+    void setMessageCallback(const UdpMessageCallback& cb) { messageCallback_ = cb; }
+    // 下面的参数传给每个UdpSocket，在start之前设置
+    void setBatchSize(int batch) { batchSize_ = batch; }
+    void setMaxDatagramSize(size_t size) { maxDatagramSize_ = size; }
+
+    void start();
+
+    // 所有socket的统计之和，可以在任意线程调用
+    UdpStats stats() const;
+
+private:
+    EventLoop* loop_; // baseloop用户定义
+    const std::string name_;
+    const InetAddress listenAddr_;
+    const Option option_;
+
+    std::shared_ptr<EventLoopThreadPool> threadPool_;
+    std::vector<UdpSocketPtr> sockets_; // start之后不再修改，各个socket只在自己的loop中收发
+
+    UdpMessageCallback messageCallback_;
+    ThreadInitCallback threadInitCallback_;
+
+    int batchSize_;
+    size_t maxDatagramSize_;
+    std::atomic_int started_;
+};
+
+#endif
@@ -0,0 +1,303 @@
+#include "UdpSocket.h"
+#include "BufferPool.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <sys/uio.h>
+
+namespace {
+// 一次可读事件最多调用recvmmsg的次数，避免一个流量很大的socket占住loop
+const int kMaxRecvRounds = 8;
+// 发送队列清空后outArena_最多保留的容量
+const size_t kMaxIdleArenaCapacity = 256 * 1024;
+}
+
+UdpSocket::UdpSocket(EventLoop* loop, const std::string& name)
+    : loop_(loop)
+    , name_(name)
+    , socket_(Socket::createNonblockingUdp())
+    , channel_(loop, socket_.fd())
+    , batchSize_(kDefaultBatchSize)
+    , maxDatagramSize_(kDefaultMaxDatagramSize)
+    , maxPendingBytes_(kDefaultMaxPendingBytes)
+    , started_(false)
+    , handlingRead_(false)
+    , flushQueued_(false)
+    , pendingHead_(0)
+    , pendingBytes_(0)
+    , received_(0)
+    , receivedBytes_(0)
+    , recvCalls_(0)
+    , sent_(0)
+    , sentBytes_(0)
+    , sendCalls_(0)
+    , truncated_(0)
+    , dropped_(0)
+{
+    channel_.setReadCallBack(std::bind(&UdpSocket::handleRead, this, std::placeholders::_1));
+    channel_.setWriteCallBack(std::bind(&UdpSocket::handleWrite, this));
+    channel_.setErrorCallBack(std::bind(&UdpSocket::handleError, this));
+}
+
+UdpSocket::~UdpSocket()
+{
+    LOG_INFO("UdpSocket::~UdpSocket [%s] fd=%d\n", name_.c_str(), socket_.fd());
+}
+
+void UdpSocket::bind(const InetAddress& addr, bool reuseport)
+{
+    socket_.setReuseAddr(true);
+    socket_.setReusePort(reuseport);
+    socket_.bindAddress(addr);
+}
+
+void UdpSocket::start()
+{
+    loop_->runInloop(std::bind(&UdpSocket::startInLoop, shared_from_this()));
+}
+
+void UdpSocket::stop()
+{
+    loop_->runInloop(std::bind(&UdpSocket::stopInLoop, shared_from_this()));
+}
+
+void UdpSocket::startInLoop()
+{
+    if (started_) {
+        return;
+    }
+    started_ = true;
+
+    recvMsgs_.resize(batchSize_);
+    recvIovecs_.resize(batchSize_);
+    recvAddrs_.resize(batchSize_);
+    sendMsgs_.resize(batchSize_);
+    sendIovecs_.resize(batchSize_);
+
+    channel_.tie(shared_from_this());
+    channel_.enableReading();
+}
+
+void UdpSocket::stopInLoop()
+{
+    if (!started_) {
+        return;
+    }
+    started_ = false;
+    channel_.disableAll();
+    channel_.remove();
+
+    // 没有发出去的数据报直接丢弃
+    dropped_.fetch_add(pending_.size() - pendingHead_, std::memory_order_relaxed);
+    pending_.clear();
+    pendingHead_ = 0;
+    pendingBytes_ = 0;
+    std::vector<char>().swap(outArena_);
+}
+
+UdpStats UdpSocket::stats() const
+{
+    UdpStats stats;
+    stats.received = received_.load(std::memory_order_relaxed);
+    stats.receivedBytes = receivedBytes_.load(std::memory_order_relaxed);
+    stats.recvCalls = recvCalls_.load(std::memory_order_relaxed);
+    stats.sent = sent_.load(std::memory_order_relaxed);
+    stats.sentBytes = sentBytes_.load(std::memory_order_relaxed);
+    stats.sendCalls = sendCalls_.load(std::memory_order_relaxed);
+    stats.truncated = truncated_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool UdpSocket::sendTo(const char* data, size_t len, const InetAddress& peer)
+{
+    if (loop_->isInLoopThread()) {
+        return sendToInLoop(data, len, *peer.getSockAddr());
+    }
+    // 数据拷贝一份随任务交给loop线程，是否超过发送队列上限要到loop线程中才知道
+    loop_->runInloop([self = shared_from_this(), buf = std::string(data, len), addr = *peer.getSockAddr()]() {
+        self->sendToInLoop(buf.data(), buf.size(), addr);
+    });
+    return true;
+}
+
+bool UdpSocket::sendToInLoop(const char* data, size_t len, const struct sockaddr_in& peer)
+{
+    if (!started_) {
+        LOG_ERROR("UdpSocket::sendTo [%s] not started, give up sending!\n", name_.c_str());
+        return false;
+    }
+    if (pendingBytes_ + len > maxPendingBytes_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    size_t offset = outArena_.size();
+    outArena_.insert(outArena_.end(), data, data + len);
+    pending_.push_back(PendingDatagram { offset, len, peer });
+    pendingBytes_ += len;
+
+    // handleRead中的回复在这一批处理完后统一发送，其他时候的发送推迟到本轮事件处理结束，
+    // 同一轮中多次sendTo合并为一次sendmmsg；已经在等待可写事件时由handleWrite发送
+    if (!handlingRead_ && !flushQueued_ && !channel_.isWriting()) {
+        flushQueued_ = true;
+        loop_->queueInloop(std::bind(&UdpSocket::flush, shared_from_this()));
+    }
+    return true;
+}
+
+void UdpSocket::flush()
+{
+    flushQueued_ = false;
+
+    while (pendingHead_ < pending_.size()) {
+        int count = static_cast<int>(std::min(pending_.size() - pendingHead_, static_cast<size_t>(batchSize_)));
+        for (int i = 0; i < count; ++i) {
+            PendingDatagram& d = pending_[pendingHead_ + i];
+            sendIovecs_[i].iov_base = outArena_.data() + d.offset;
+            sendIovecs_[i].iov_len = d.len;
+
+            struct msghdr& hdr = sendMsgs_[i].msg_hdr;
+            ::memset(&hdr, 0, sizeof hdr);
+            hdr.msg_name = &d.peer;
+            hdr.msg_namelen = sizeof d.peer;
+            hdr.msg_iov = &sendIovecs_[i];
+            hdr.msg_iovlen = 1;
+        }
+
+        int n = ::sendmmsg(socket_.fd(), sendMsgs_.data(), count, 0);
+        if (n < 0) {
+            int savedErrno = errno;
+            if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+                // socket发送缓冲区满了，等可写事件再发送剩下的
+                if (!channel_.isWriting()) {
+                    channel_.enableWriting();
+                }
+                compactPending();
+                return;
+            }
+            // 第一个数据报发送出错，例如EMSGSIZE，UDP不重传，丢弃它继续发送后面的
+            LOG_ERROR("UdpSocket::flush [%s] sendmmsg errno=%d\n", name_.c_str(), savedErrno);
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            pendingBytes_ -= pending_[pendingHead_].len;
+            ++pendingHead_;
+            continue;
+        }
+
+        size_t bytes = 0;
+        for (int i = 0; i < n; ++i) {
+            bytes += pending_[pendingHead_ + i].len;
+        }
+        sendCalls_.fetch_add(1, std::memory_order_relaxed);
+        sent_.fetch_add(n, std::memory_order_relaxed);
+        sentBytes_.fetch_add(bytes, std::memory_order_relaxed);
+        pendingBytes_ -= bytes;
+        pendingHead_ += n;
+    }
+
+    pending_.clear();
+    pendingHead_ = 0;
+    outArena_.clear();
+    if (outArena_.capacity() > kMaxIdleArenaCapacity) {
+        std::vector<char>().swap(outArena_);
+    }
+    if (channel_.isWriting()) {
+        channel_.disableWriting();
+    }
+}
+
+// 发送队列一直没有清空时，已经发送的前缀也要回收，否则持续EAGAIN时outArena_会无限增长，
+// 已发送的部分不少于未发送的部分时才搬移，搬移的字节数不超过回收的字节数
+void UdpSocket::compactPending()
+{
+    if (pendingHead_ == 0) {
+        return;
+    }
+    size_t sentBytes = pendingHead_ < pending_.size() ? pending_[pendingHead_].offset : outArena_.size();
+    if (sentBytes < outArena_.size() - sentBytes) {
+        return;
+    }
+
+    outArena_.erase(outArena_.begin(), outArena_.begin() + sentBytes);
+    pending_.erase(pending_.begin(), pending_.begin() + pendingHead_);
+    pendingHead_ = 0;
+    for (PendingDatagram& d : pending_) {
+        d.offset -= sentBytes;
+    }
+}
+
+void UdpSocket::handleRead(Timestamp receiveTime)
+{
+    // 每个数据报占maxDatagramSize_字节，这一批处理完就把内存还给loop的BufferPool
+    BufferPool* pool = loop_->bufferPool();
+    std::vector<char> arena(pool->acquire(batchSize_ * maxDatagramSize_));
+    UdpSocketPtr self(shared_from_this());
+
+    handlingRead_ = true;
+    for (int round = 0; round < kMaxRecvRounds; ++round) {
+        for (int i = 0; i < batchSize_; ++i) {
+            recvIovecs_[i].iov_base = arena.data() + i * maxDatagramSize_;
+            recvIovecs_[i].iov_len = maxDatagramSize_;
+
+            struct msghdr& hdr = recvMsgs_[i].msg_hdr;
+            ::memset(&hdr, 0, sizeof hdr);
+            hdr.msg_name = &recvAddrs_[i];
+            hdr.msg_namelen = sizeof recvAddrs_[i];
+            hdr.msg_iov = &recvIovecs_[i];
+            hdr.msg_iovlen = 1;
+        }
+
+        int n = ::recvmmsg(socket_.fd(), recvMsgs_.data(), batchSize_, MSG_DONTWAIT, nullptr);
+        if (n < 0) {
+            int savedErrno = errno;
+            if (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK) {
+                LOG_ERROR("UdpSocket::handleRead [%s] recvmmsg errno=%d\n", name_.c_str(), savedErrno);
+            }
+            break;
+        }
+
+        recvCalls_.fetch_add(1, std::memory_order_relaxed);
+        for (int i = 0; i < n; ++i) {
+            const struct msghdr& hdr = recvMsgs_[i].msg_hdr;
+            if (hdr.msg_flags & MSG_TRUNC) {
+                truncated_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            size_t len = recvMsgs_[i].msg_len;
+            received_.fetch_add(1, std::memory_order_relaxed);
+            receivedBytes_.fetch_add(len, std::memory_order_relaxed);
+            if (messageCallback_) {
+                messageCallback_(self, static_cast<const char*>(recvIovecs_[i].iov_base), len,
+                    InetAddress(recvAddrs_[i]), receiveTime);
+            }
+        }
+
+        if (n < batchSize_ || !started_) {
+            break; // 已经收空，或者回调中调用了stop
+        }
+    }
+    handlingRead_ = false;
+
+    pool->release(std::move(arena));
+
+    // 这一批回调中的回复一起发送
+    if (pendingHead_ < pending_.size() && !channel_.isWriting()) {
+        flush();
+    }
+}
+
+void UdpSocket::handleWrite()
+{
+    flush();
+}
+
+void UdpSocket::handleError()
+{
+    int err = socket_.getSocketError(socket_.fd());
+    LOG_ERROR("UdpSocket::handleError [%s] - SO_ERROR: %d\n", name_.c_str(), err);
+}
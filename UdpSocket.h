@@ -0,0 +1,135 @@
+#ifndef UDPSOCKET_H
+#define UDPSOCKET_H
+
+#pragma once
+#include "Callbacks.h"
+#include "Channel.h"
+#include "InetAddress.h"
+#include "Socket.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+class EventLoop;
+class Timestamp;
+
+// UDP收发的统计，可以在其他线程读取
+struct UdpStats {
+    uint64_t received = 0; // 收到的数据报个数
+    uint64_t receivedBytes = 0;
+    uint64_t recvCalls = 0; // recvmmsg调用次数
+    uint64_t sent = 0; // 发送成功的数据报个数
+    uint64_t sentBytes = 0;
+    uint64_t sendCalls = 0; // sendmmsg调用次数
+    uint64_t truncated = 0; // 超过maxDatagramSize被截断而丢弃的数据报个数
+    uint64_t dropped = 0; // 发送队列超过上限或者发送出错而丢弃的数据报个数
+};
+
+//
+// 一个非阻塞UDP socket，注册在EventLoop上
+// 可读时用recvmmsg一次收取最多batchSize个数据报，收到的数据放在从loop的BufferPool借来的一块连续内存中，
+// 每个数据报占maxDatagramSize字节，处理完这一批就归还，同一个loop上的多个UdpSocket共用池中的内存
+// sendTo把数据报拷贝进发送队列，本轮事件处理结束时用sendmmsg一次发出，
+// 因此在消息回调中逐个回复的数据报会和这一批收到的数据报一样批量发送
+// 与TcpConnection一样由shared_ptr管理，Channel通过tie保证回调期间对象存活
+//
+class UdpSocket : noncopyable, public std::enable_shared_from_this<UdpSocket> {
+public:
+    static const int kDefaultBatchSize = 64;
+    static const size_t kDefaultMaxDatagramSize = 2048;
+    static const size_t kDefaultMaxPendingBytes = 4 * 1024 * 1024;
+
+    UdpSocket(EventLoop* loop, const std::string& name);
+    ~UdpSocket();
+
+    EventLoop* getLoop() const { return loop_; }
+    const std::string& name() const { return name_; }
+    int fd() const { return socket_.fd(); }
+    InetAddress localAddress() const { return InetAddress(Socket::getLocalAddr(socket_.fd())); }
+
+    // 在start之前调用，reuseport为true时多个socket可以绑定同一个地址，由内核按四元组分配数据报
+    void bind(const InetAddress& addr, bool reuseport = false);
+
+    void setMessageCallback(UdpMessageCallback cb) { messageCallback_ = std::move(cb); }
+    // 每次recvmmsg/sendmmsg最多处理的数据报个数，在start之前设置
+    void setBatchSize(int batch) { batchSize_ = batch > 0 ? batch : 1; }
+    // 接收时每个数据报预留的空间，超过的数据报被丢弃，在start之前设置
+    void setMaxDatagramSize(size_t size) { maxDatagramSize_ = size > 0 ? size : 1; }
+    // 发送队列最多缓存的字节数，对端收不过来时超过的数据报直接丢弃
+    void setMaxPendingBytes(size_t bytes) { maxPendingBytes_ = bytes; }
+
+    // 开始/停止接收，都在loop线程中执行
+    void start();
+    void stop();
+
+    // 发送一个数据报，在其他线程调用时数据拷贝后交给loop线程发送
+    // 发送队列超过上限时丢弃并返回false
+    bool sendTo(const char* data, size_t len, const InetAddress& peer);
+    bool sendTo(const std::string& data, const InetAddress& peer) { return sendTo(data.data(), data.size(), peer); }
+    // 立刻用sendmmsg发送队列中的数据报，只能在loop线程中调用
+    void flush();
+
+    size_t pendingBytes() const { return pendingBytes_; } // 只能在loop线程中读取
+    UdpStats stats() const;
+
+private:
+    // 发送队列中的一个数据报，数据在outArena_中
+    struct PendingDatagram {
+        size_t offset;
+        size_t len;
+        struct sockaddr_in peer;
+    };
+
+    void startInLoop();
+    void stopInLoop();
+    bool sendToInLoop(const char* data, size_t len, const struct sockaddr_in& peer);
+    // 回收发送队列中已经发送的前缀
+    void compactPending();
+
+    void handleRead(Timestamp receiveTime);
+    void handleWrite();
+    void handleError();
+
+    EventLoop* loop_;
+    const std::string name_;
+    Socket socket_;
+    Channel channel_;
+    UdpMessageCallback messageCallback_;
+
+    int batchSize_;
+    size_t maxDatagramSize_;
+    size_t maxPendingBytes_;
+    bool started_;
+    bool handlingRead_; // 正在handleRead中，回调里的sendTo等这一批处理完再一起发送
+    bool flushQueued_; // 已经queueInloop了一次flush
+
+    // recvmmsg/sendmmsg的参数数组，长度为batchSize_，只分配一次
+    std::vector<struct mmsghdr> recvMsgs_;
+    std::vector<struct iovec> recvIovecs_;
+    std::vector<struct sockaddr_in> recvAddrs_;
+    std::vector<struct mmsghdr> sendMsgs_;
+    std::vector<struct iovec> sendIovecs_;
+
+    std::vector<char> outArena_; // 发送队列中所有数据报的数据
+    std::vector<PendingDatagram> pending_;
+    size_t pendingHead_; // pending_中第一个还没有发送的数据报，之前的在compactPending时回收
+    size_t pendingBytes_;
+
+    std::atomic<uint64_t> received_;
+    std::atomic<uint64_t> receivedBytes_;
+    std::atomic<uint64_t> recvCalls_;
+    std::atomic<uint64_t> sent_;
+    std::atomic<uint64_t> sentBytes_;
+    std::atomic<uint64_t> sendCalls_;
+    std::atomic<uint64_t> truncated_;
+    std::atomic<uint64_t> dropped_;
+};
+
+#endif
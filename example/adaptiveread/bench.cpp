@@ -0,0 +1,169 @@
+#include <mymuduo/Buffer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpConnection.h>
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// 对比readFd固定使用64KB extrabuf和自适应预留空间时，每接收1字节额外拷贝的字节数
+// bulk: 客户端不停地发送64KB数据块，服务端收到就丢弃，模拟大文件上传
+// rpc: 客户端发送msgSize字节的请求，服务端收齐一个请求后回复1字节，客户端收到回复再发下一个
+// short: 每个请求一个新连接，发送msgSize字节后关闭，模拟短连接上传
+// 客户端在子进程中，服务端单线程，默认不使用BufferPool，否则扩容过的内存会在池中留给下一次读取，看不出readFd本身的区别
+
+enum Mode { kBulk, kRpc, kShort };
+
+Mode g_mode = kBulk;
+size_t g_msgSize = 16 * 1024;
+bool g_adaptive = true;
+int64_t g_received = 0;
+int64_t g_copied = 0;
+int64_t g_reads = 0;
+int g_connections = 1; // 全部连接断开后退出
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected()) {
+        conn->setAdaptiveRead(g_adaptive);
+    } else {
+        // 连接断开时在loop线程中汇总这个连接inputBuffer_的统计
+        g_received += conn->inputBuffer().receivedBytes();
+        g_copied += conn->inputBuffer().copiedBytes();
+        if (--g_connections == 0) {
+            conn->getLoop()->quit();
+        }
+    }
+}
+
+void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    ++g_reads;
+    if (g_mode != kRpc) {
+        buf->retrieveAll();
+        return;
+    }
+    while (buf->readableBytes() >= g_msgSize) {
+        buf->retrieve(g_msgSize);
+        conn->send("k");
+    }
+}
+
+int connectServer(uint16_t port)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+        ::perror("connect");
+        ::_exit(1);
+    }
+    int one = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return sockfd;
+}
+
+void runClient(uint16_t port, int64_t totalBytes)
+{
+    if (g_mode == kShort) {
+        std::string request(g_msgSize, 's');
+        for (int64_t sent = 0; sent < totalBytes; sent += g_msgSize) {
+            int sockfd = connectServer(port);
+            if (::write(sockfd, request.data(), request.size()) != static_cast<ssize_t>(request.size())) {
+                ::close(sockfd);
+                break;
+            }
+            ::shutdown(sockfd, SHUT_WR);
+            char c;
+            while (::read(sockfd, &c, 1) > 0) { // 等服务端关闭，保证数据都被读取
+            }
+            ::close(sockfd);
+        }
+        return;
+    }
+
+    int sockfd = connectServer(port);
+    if (g_mode == kBulk) {
+        std::string chunk(64 * 1024, 'b');
+        for (int64_t sent = 0; sent < totalBytes;) {
+            ssize_t n = ::write(sockfd, chunk.data(), chunk.size());
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+    } else {
+        std::string request(g_msgSize, 'r');
+        char reply;
+        for (int64_t sent = 0; sent < totalBytes; sent += g_msgSize) {
+            if (::write(sockfd, request.data(), request.size()) != static_cast<ssize_t>(request.size())
+                || ::read(sockfd, &reply, 1) != 1) {
+                break;
+            }
+        }
+    }
+    ::close(sockfd);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s fixed|adaptive bulk|rpc|short [MB] [msgSize] [pool]\n", argv[0]);
+        return 1;
+    }
+
+    g_adaptive = ::strcmp(argv[1], "adaptive") == 0;
+    g_mode = ::strcmp(argv[2], "rpc") == 0 ? kRpc : (::strcmp(argv[2], "short") == 0 ? kShort : kBulk);
+    int64_t totalBytes = (argc > 3 ? ::atoll(argv[3]) : 512) * 1024 * 1024;
+    if (argc > 4) {
+        g_msgSize = ::atoi(argv[4]);
+    }
+    bool pool = argc > 5 && ::strcmp(argv[5], "pool") == 0;
+    if (g_mode == kShort) {
+        g_connections = static_cast<int>(totalBytes / g_msgSize);
+    }
+    uint16_t port = 7899;
+
+    Logger::setLogLevel(ERROR);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port, "127.0.0.1"), "AdaptiveRead");
+    server.setConnectionCallback(onConnection);
+    server.setMessageCallback(onMessage);
+    server.setUseBufferPool(pool);
+    server.start();
+
+    Timestamp start(Timestamp::now());
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        runClient(port, totalBytes);
+        ::_exit(0);
+    }
+    loop.loop();
+    double elapsed = timeDifference(Timestamp::now(), start);
+    ::waitpid(pid, nullptr, 0);
+
+    fprintf(stderr, "[%s %s%s] received=%lld MB reads=%lld (%.0f bytes/read) copied=%lld MB copy/recv=%.3f throughput=%.0f MiB/s\n",
+        argv[1], argv[2], pool ? " pool" : "", static_cast<long long>(g_received >> 20), static_cast<long long>(g_reads),
+        g_reads > 0 ? static_cast<double>(g_received) / g_reads : 0.0,
+        static_cast<long long>(g_copied >> 20), g_received > 0 ? static_cast<double>(g_copied) / g_received : 0.0,
+        g_received / 1048576.0 / elapsed);
+    return 0;
+}
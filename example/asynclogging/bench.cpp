@@ -0,0 +1,95 @@
+#include <mymuduo/AsyncLogging.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+// 多个线程同时写LOG_INFO，统计每秒日志条数以及调用方单条日志耗时的p99
+// sync:  原来的输出方式 每条日志写stdout并刷新，运行时把stdout重定向到文件
+// async: AsyncLogging 前端写内存缓冲区，后台线程写滚动文件
+
+AsyncLogging* g_asyncLog = nullptr;
+
+void asyncOutput(const char* msg, size_t len)
+{
+    g_asyncLog->append(msg, len);
+}
+
+// 模拟原来每条日志都std::endl刷新的输出
+void syncOutput(const char* msg, size_t len)
+{
+    ::fwrite(msg, 1, len, stdout);
+    ::fflush(stdout);
+}
+
+int64_t nowNs()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s sync|async [threads] [messages_per_thread]\n", argv[0]);
+        return 1;
+    }
+
+    bool async = ::strcmp(argv[1], "async") == 0;
+    int threads = argc > 2 ? ::atoi(argv[2]) : 4;
+    int messages = argc > 3 ? ::atoi(argv[3]) : 200000;
+
+    if (async) {
+        g_asyncLog = new AsyncLogging("/tmp/mymuduo_bench", 500 * 1000 * 1000);
+        g_asyncLog->start();
+        Logger::setOutput(asyncOutput);
+    } else {
+        Logger::setOutput(syncOutput);
+    }
+
+    std::vector<std::vector<int64_t>> latencies(threads);
+    std::vector<std::thread> workers;
+    Timestamp start(Timestamp::now());
+
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([i, messages, &latencies] {
+            std::vector<int64_t>& lat = latencies[i];
+            lat.reserve(messages);
+            for (int j = 0; j < messages; ++j) {
+                int64_t begin = nowNs();
+                LOG_INFO("TcpConnection::connector[bench-127.0.0.1:8000#%d] at fd=%d\n", j, i);
+                lat.push_back(nowNs() - begin);
+            }
+        });
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    double seconds = timeDifference(Timestamp::now(), start);
+
+    if (async) {
+        g_asyncLog->stop();
+    }
+
+    std::vector<int64_t> all;
+    for (auto& lat : latencies) {
+        all.insert(all.end(), lat.begin(), lat.end());
+    }
+    std::sort(all.begin(), all.end());
+    int64_t total = static_cast<int64_t>(all.size());
+
+    fprintf(stderr, "[%s] threads=%d messages=%lld time=%.3fs %.0f msgs/s p50=%lldns p99=%lldns max=%lldns\n",
+        async ? "async" : "sync", threads, static_cast<long long>(total), seconds, total / seconds,
+        static_cast<long long>(all[total / 2]),
+        static_cast<long long>(all[total * 99 / 100]),
+        static_cast<long long>(all.back()));
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <mymuduo/Buffer.h>
+#include <mymuduo/BufferPool.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpConnection.h>
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <future>
+#include <mutex>
+#include <netinet/in.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// 每个空闲连接占用的内存 pool模式下收发缓冲区从loop的BufferPool借，处理完就归还，
+// nopool模式下每个连接的inputBuffer_一直持有扩容后的内存
+// 客户端在子进程中建立clients个连接，每个连接发送一条msgSize字节的消息并等待回显，之后连接保持空闲，
+// 统计所有连接空闲后服务端RSS的增量
+
+int g_msgSize = 4096;
+std::mutex g_mutex;
+std::vector<EventLoop*> g_loops;
+
+void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    if (buf->readableBytes() >= static_cast<size_t>(g_msgSize)) {
+        conn->send(buf->retrieveAsString(g_msgSize));
+    }
+}
+
+long rssKB()
+{
+    FILE* fp = ::fopen("/proc/self/statm", "r");
+    long pages = 0, resident = 0;
+    if (fp) {
+        if (::fscanf(fp, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        ::fclose(fp);
+    }
+    return resident * (::sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// 所有连接都收到回显后向readyFd写一个字节，然后保持连接直到被kill
+void runClients(uint16_t port, int clients, int readyFd)
+{
+    std::vector<int> fds;
+    std::string msg(g_msgSize, 'm');
+    std::vector<char> reply(g_msgSize);
+    for (int i = 0; i < clients; ++i) {
+        int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        ::memset(&addr, 0, sizeof addr);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+            ::close(sockfd);
+            continue;
+        }
+        if (::write(sockfd, msg.data(), msg.size()) != static_cast<ssize_t>(msg.size())) {
+            ::close(sockfd);
+            continue;
+        }
+        fds.push_back(sockfd);
+    }
+
+    for (int fd : fds) {
+        size_t got = 0;
+        while (got < reply.size()) {
+            ssize_t n = ::read(fd, reply.data() + got, reply.size() - got);
+            if (n <= 0) {
+                break;
+            }
+            got += n;
+        }
+    }
+
+    char c = 1;
+    if (::write(readyFd, &c, 1) != 1) {
+        ::_exit(1);
+    }
+    ::pause();
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s pool|nopool [clients] [msgSize] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    bool pool = ::strcmp(argv[1], "pool") == 0;
+    int clients = argc > 2 ? ::atoi(argv[2]) : 8000;
+    g_msgSize = argc > 3 ? ::atoi(argv[3]) : 4096;
+    int threads = argc > 4 ? ::atoi(argv[4]) : 4;
+    uint16_t port = 7898;
+
+    Logger::setLogLevel(FATAL);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port, "127.0.0.1"), "BufferPool");
+    server.setThreadNum(threads);
+    server.setUseBufferPool(pool);
+    server.setMessageCallback(onMessage);
+    server.setThreadInitCallback([](EventLoop* ioloop) {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_loops.push_back(ioloop);
+    });
+    server.start();
+
+    int pipefd[2];
+    if (::pipe2(pipefd, O_NONBLOCK) < 0) {
+        perror("pipe2");
+        return 1;
+    }
+
+    long rssBefore = rssKB();
+    Timestamp start(Timestamp::now());
+
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(pipefd[0]);
+        runClients(port, clients, pipefd[1]);
+        ::_exit(0);
+    }
+    ::close(pipefd[1]);
+
+    loop.runEvery(0.05, [&] {
+        char c;
+        if (::read(pipefd[0], &c, 1) == 1) {
+            double elapsed = timeDifference(Timestamp::now(), start);
+            long rssAfter = rssKB();
+            fprintf(stderr, "[%s] clients=%d msg=%dB threads=%d setup+echo=%.2fs rss %ld KB -> %ld KB, %.0f bytes per idle connection\n",
+                pool ? "pool" : "nopool", clients, g_msgSize, threads, elapsed, rssBefore, rssAfter,
+                (rssAfter - rssBefore) * 1024.0 / clients);
+            loop.quit();
+        }
+    });
+    loop.loop();
+
+    // BufferPool的统计只能在所属loop线程中读取
+    if (pool) {
+        for (EventLoop* ioloop : g_loops) {
+            std::promise<BufferPool::Stats> promise;
+            ioloop->runInloop([&] { promise.set_value(ioloop->bufferPool()->stats()); });
+            BufferPool::Stats stats = promise.get_future().get();
+            fprintf(stderr, "  pool acquired=%lld reused=%lld released=%lld dropped=%lld pooled=%zu KB\n",
+                static_cast<long long>(stats.acquired), static_cast<long long>(stats.reused),
+                static_cast<long long>(stats.released), static_cast<long long>(stats.dropped),
+                stats.pooledBytes / 1024);
+        }
+    }
+
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// 连接风暴测试 clients个客户端线程不停地connect再RST关闭，统计服务端每秒accept的连接数
+// single:    mainloop每次可读只accept一个连接，即原来的Acceptor
+// batch:     mainloop每次可读最多accept batch个连接
+// reuseport: kReusePortPerLoop 每个subloop各自accept
+
+std::atomic_bool g_running(true);
+
+void connectLoop(uint16_t port, std::atomic<int64_t>* connected)
+{
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    // SO_LINGER为0时close直接发RST，客户端不会留下大量TIME_WAIT把临时端口用完
+    struct linger lin;
+    lin.l_onoff = 1;
+    lin.l_linger = 0;
+
+    while (g_running) {
+        int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        ::setsockopt(sockfd, SOL_SOCKET, SO_LINGER, &lin, sizeof lin);
+        if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) == 0) {
+            ++*connected;
+        }
+        ::close(sockfd);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s single|batch|reuseport [threads] [clients] [seconds] [batch]\n", argv[0]);
+        return 1;
+    }
+
+    const char* mode = argv[1];
+    int threads = argc > 2 ? ::atoi(argv[2]) : 4;
+    int clients = argc > 3 ? ::atoi(argv[3]) : 8;
+    int seconds = argc > 4 ? ::atoi(argv[4]) : 5;
+    int batch = argc > 5 ? ::atoi(argv[5]) : 64;
+    uint16_t port = 7895;
+
+    Logger::setLogLevel(FATAL); // 客户端RST关闭会产生大量ERROR日志
+
+    EventLoop loop;
+    TcpServer::Option option = ::strcmp(mode, "reuseport") == 0 ? TcpServer::kReusePortPerLoop : TcpServer::kNoReusePort;
+    TcpServer server(&loop, InetAddress(port, "127.0.0.1"), "ConnStorm", option);
+    server.setThreadNum(threads);
+    server.setAcceptBatch(::strcmp(mode, "single") == 0 ? 1 : batch);
+    server.start();
+
+    std::atomic<int64_t> connected(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < clients; ++i) {
+        workers.emplace_back(connectLoop, port, &connected);
+    }
+
+    Timestamp start(Timestamp::now());
+    loop.runAfter(seconds, [&] {
+        g_running = false;
+        loop.quit();
+    });
+    loop.loop();
+    double elapsed = timeDifference(Timestamp::now(), start);
+
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    AcceptStats stats = server.acceptStats();
+    fprintf(stderr, "[%s] threads=%d clients=%d time=%.2fs accepted=%llu (%.0f/s) failed=%llu rejected=%llu connected=%lld\n",
+        mode, threads, clients, elapsed,
+        static_cast<unsigned long long>(stats.accepted), stats.accepted / elapsed,
+        static_cast<unsigned long long>(stats.failed),
+        static_cast<unsigned long long>(stats.rejected),
+        static_cast<long long>(connected.load()));
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpConnection.h>
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// 大量慢速读取的客户端下，对比LT和ET模式的epoll_ctl次数、吞吐量和服务端CPU
+// 服务端每个连接不停地发送64KB数据块，outputBuffer_清空后立刻发送下一块，
+// LT模式下每次发送缓冲区写满再清空都要enableWriting/disableWriting两次epoll_ctl
+// 客户端在子进程中，每轮每个连接只读4KB，然后休眠
+
+std::atomic<int64_t> g_epollCtlCalls(0);
+std::atomic<int64_t> g_chunksSent(0);
+
+// 替换libc的epoll_ctl，统计调用次数
+extern "C" int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event)
+{
+    using EpollCtl = int (*)(int, int, int, struct epoll_event*);
+    static EpollCtl realEpollCtl = reinterpret_cast<EpollCtl>(::dlsym(RTLD_NEXT, "epoll_ctl"));
+    ++g_epollCtlCalls;
+    return realEpollCtl(epfd, op, fd, event);
+}
+
+const std::string g_chunk(64 * 1024, 'x');
+
+void sendChunk(const TcpConnectionPtr& conn)
+{
+    ++g_chunksSent;
+    conn->send(g_chunk);
+}
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected()) {
+        sendChunk(conn);
+    }
+}
+
+void runClients(uint16_t port, int clients, int seconds)
+{
+    std::vector<int> fds;
+    for (int i = 0; i < clients; ++i) {
+        int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr;
+        ::memset(&addr, 0, sizeof addr);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+            ::close(sockfd);
+            continue;
+        }
+        ::fcntl(sockfd, F_SETFL, O_NONBLOCK);
+        fds.push_back(sockfd);
+    }
+
+    char buf[4096];
+    Timestamp start(Timestamp::now());
+    while (timeDifference(Timestamp::now(), start) < seconds) {
+        for (int fd : fds) {
+            ssize_t n = ::read(fd, buf, sizeof buf);
+            (void)n;
+        }
+        ::usleep(200);
+    }
+    for (int fd : fds) {
+        ::close(fd);
+    }
+}
+
+double cpuSeconds()
+{
+    struct rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+        + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s lt|et [threads] [clients] [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    bool et = ::strcmp(argv[1], "et") == 0;
+    int threads = argc > 2 ? ::atoi(argv[2]) : 2;
+    int clients = argc > 3 ? ::atoi(argv[3]) : 200;
+    int seconds = argc > 4 ? ::atoi(argv[4]) : 5;
+    uint16_t port = 7897;
+
+    Logger::setLogLevel(FATAL); // 结束时客户端直接关闭，屏蔽发送失败的ERROR日志
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port, "127.0.0.1"), "EdgeTrigger");
+    server.setThreadNum(threads);
+    server.setEdgeTriggered(et);
+    server.setConnectionCallback(onConnection);
+    server.setWriteCompleteCallback(sendChunk);
+    server.start();
+
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        runClients(port, clients, seconds);
+        ::_exit(0);
+    }
+
+    // 等客户端都连上之后再开始统计
+    ::usleep(500 * 1000);
+    int64_t ctlStart = g_epollCtlCalls;
+    int64_t chunksStart = g_chunksSent;
+    double cpuStart = cpuSeconds();
+    Timestamp start(Timestamp::now());
+
+    loop.runAfter(seconds - 1, [&] { loop.quit(); });
+    loop.loop();
+
+    double elapsed = timeDifference(Timestamp::now(), start);
+    double cpu = cpuSeconds() - cpuStart;
+    int64_t ctl = g_epollCtlCalls - ctlStart;
+    double mib = (g_chunksSent - chunksStart) * 64.0 / 1024;
+
+    fprintf(stderr, "[%s] threads=%d clients=%d time=%.2fs epoll_ctl=%lld (%.0f/s) throughput=%.1f MiB/s server_cpu=%.2fs (%.3fs per GiB)\n",
+        et ? "et" : "lt", threads, clients, elapsed,
+        static_cast<long long>(ctl), ctl / elapsed, mib / elapsed, cpu, mib > 0 ? cpu / (mib / 1024) : 0.0);
+
+    ::waitpid(pid, nullptr, 0);
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <mymuduo/Callbacks.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpConnection.h>
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// 文件下载吞吐量测试，clients个客户端线程各自下载times次文件，统计总吞吐量
+// copy:     原来download的做法 每个连接把整个文件读入string再send
+// sendfile: TcpConnection::sendFile 零拷贝发送
+
+const char* g_file = nullptr;
+bool g_sendfile = false;
+
+std::string readFile(const char* filename)
+{
+    std::string content;
+    FILE* fp = ::fopen(filename, "rb");
+    if (fp) {
+        char buf[64 * 1024];
+        size_t nread = 0;
+        while ((nread = ::fread(buf, 1, sizeof buf, fp)) > 0) {
+            content.append(buf, nread);
+        }
+        ::fclose(fp);
+    }
+    return content;
+}
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+    if (!conn->connected()) {
+        return;
+    }
+
+    if (g_sendfile) {
+        int fd = ::open(g_file, O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        ::fstat(fd, &st);
+        conn->sendFile(fd, 0, static_cast<size_t>(st.st_size),
+            [fd](const TcpConnectionPtr&, bool) { ::close(fd); });
+    } else {
+        conn->send(readFile(g_file));
+    }
+    conn->shutdown();
+}
+
+// 阻塞socket下载一次文件，返回收到的字节数
+int64_t download(uint16_t port)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+        ::close(sockfd);
+        return 0;
+    }
+
+    static thread_local char buf[256 * 1024];
+    int64_t total = 0;
+    ssize_t n = 0;
+    while ((n = ::read(sockfd, buf, sizeof buf)) > 0) {
+        total += n;
+    }
+    ::close(sockfd);
+    return total;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s file copy|sendfile [clients] [times] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    g_file = argv[1];
+    g_sendfile = ::strcmp(argv[2], "sendfile") == 0;
+    int clients = argc > 3 ? ::atoi(argv[3]) : 4;
+    int times = argc > 4 ? ::atoi(argv[4]) : 20;
+    int threads = argc > 5 ? ::atoi(argv[5]) : 2;
+    uint16_t port = 7891;
+
+    Logger::setLogLevel(ERROR); // 屏蔽连接建立断开的INFO日志
+
+    EventLoop loop;
+    InetAddress listenAddr(port, "127.0.0.1");
+    TcpServer server(&loop, listenAddr, "FileBench", TcpServer::kReusePort);
+    server.setConnectionCallback(onConnection);
+    server.setThreadNum(threads);
+    server.start();
+
+    std::atomic<int64_t> totalBytes(0);
+    std::atomic<int> finished(0);
+    Timestamp start(Timestamp::now());
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < clients; ++i) {
+        workers.emplace_back([&] {
+            for (int j = 0; j < times; ++j) {
+                totalBytes += download(port);
+            }
+            if (++finished == clients) {
+                loop.quit();
+            }
+        });
+    }
+
+    loop.loop();
+    double seconds = timeDifference(Timestamp::now(), start);
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    fprintf(stderr, "[%s] clients=%d times=%d bytes=%lld time=%.3fs throughput=%.1f MiB/s\n",
+        g_sendfile ? "sendfile" : "copy", clients, times,
+        static_cast<long long>(totalBytes.load()), seconds,
+        totalBytes.load() / seconds / 1024 / 1024);
+    return 0;
+}
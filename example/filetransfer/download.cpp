@@ -1,5 +1,6 @@
 #include <cstddef>
 #include <cstdio>
+#include <fcntl.h>
 #include <functional>
 #include <mymuduo/Callbacks.h>
 #include <mymuduo/EventLoop.h>
@@ -7,37 +8,24 @@
 #include <mymuduo/Logger.h>
 #include <mymuduo/TcpServer.h>
 #include <string>
+#include <sys/stat.h>
 #include <unistd.h>
 
-// 一次性把文件读入内存，一次性调用send发送完毕，
-// 文件过大占用很大内存
+// 每个连接打开一次文件，用sendFile零拷贝发送，
+// 数据由内核从page cache直接拷贝到socket，不占用用户态内存，文件多大都可以
 
 const char* g_file = nullptr;
 
-std::string readFile(const char* filename)
+void onHighWaterMark(const TcpConnectionPtr& conn, size_t len)
 {
-    std::string content;
-    FILE* fp = ::fopen(filename, "rb");
-
-    // 文件越大内存消耗越多
-    if (fp) {
-        const int kBufSize = 1024 * 1024; // 1MB
-        char iobuf[kBufSize];
-        ::setbuffer(fp, iobuf, sizeof iobuf);
-
-        char buf[kBufSize];
-        size_t nread = 0;
-        while ((nread = ::fread(buf, 1, sizeof buf, fp)) > 0) {
-            content.append(buf, nread);
-        }
-        ::fclose(fp);
-    }
-    return content;
+    LOG_INFO("HighWaterMark %zu", len);
 }
 
-void onHighWaterMark(const TcpConnectionPtr& conn, size_t len)
+// 文件发送完成或连接断开时调用，关闭文件
+void onSendFileComplete(int fd, const TcpConnectionPtr& conn, bool ok)
 {
-    LOG_INFO("HighWaterMark %zu", len);
+    LOG_INFO("FileServer - %s send file %s\n", conn->peerAddress().toIpPort().c_str(), ok ? "done" : "failed");
+    ::close(fd);
 }
 
 void onConnection(const TcpConnectionPtr& conn)
@@ -50,11 +38,21 @@ void onConnection(const TcpConnectionPtr& conn)
 
         conn->setHighWaterMarkCallback(std::bind(&onHighWaterMark, std::placeholders::_1, 64 * 1024));
 
-        // 考虑到文件可能被修改，每次建立连接都把文件读一遍
-        std::string fileContent = readFile(g_file);
-        conn->send(fileContent);
-        conn->shutdown();
-        LOG_INFO("FIleServer - done\n");
+        // 考虑到文件可能被修改，每次建立连接都重新打开文件
+        int fd = ::open(g_file, O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) < 0) {
+            LOG_ERROR("FileServer - open %s failed\n", g_file);
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            conn->shutdown();
+            return;
+        }
+
+        conn->sendFile(fd, 0, static_cast<size_t>(st.st_size),
+            std::bind(&onSendFileComplete, fd, std::placeholders::_1, std::placeholders::_2));
+        conn->shutdown(); // 等文件发送完成后才真正关闭写端
 
     } else {
         LOG_INFO("FileServer - %s -> %s is DOWN.\n",
@@ -0,0 +1,186 @@
+#include "../../http/HttpContext.h"
+#include "../../http/HttpRequest.h"
+#include "../../http/HttpResponse.h"
+#include "../../http/HttpServer.h"
+
+#include <mymuduo/Buffer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// 统计每个HTTP请求的堆内存分配次数，替换全局operator new计数
+// parse: 只解析一个浏览器风格的GET请求(11个请求头)，请求一次全部收到或者分两次收到
+// server: 通过HttpServer处理长连接上的GET请求，包括构造HttpResponse和发送，统计服务端进程中的分配次数
+// 用法: ./bench [requests]
+
+std::atomic<int64_t> g_allocs(0);
+
+void* operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+const char* kRequest = "GET /index.html?lang=en&page=2 HTTP/1.1\r\n"
+                       "Host: www.example.com\r\n"
+                       "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+                       "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+                       "Accept-Language: en-US,en;q=0.9\r\n"
+                       "Accept-Encoding: gzip, deflate, br\r\n"
+                       "Connection: keep-alive\r\n"
+                       "Cache-Control: max-age=0\r\n"
+                       "Upgrade-Insecure-Requests: 1\r\n"
+                       "Referer: https://www.example.com/\r\n"
+                       "Cookie: session=0123456789abcdef; theme=dark\r\n"
+                       "Sec-Fetch-Mode: navigate\r\n"
+                       "\r\n";
+
+int64_t g_checksum = 0;
+
+void benchParse(int requests, bool split)
+{
+    HttpContext context;
+    Buffer buf;
+    size_t len = ::strlen(kRequest);
+    size_t half = split ? len / 2 : len;
+
+    int64_t before = 0;
+    Timestamp start;
+    for (int i = -100; i < requests; ++i) {
+        if (i == 0) { // 前100次预热，Buffer等扩容到稳定大小
+            before = g_allocs.load();
+            start = Timestamp::now();
+        }
+        buf.append(kRequest, half);
+        context.parseRequest(&buf, Timestamp());
+        if (split) {
+            buf.append(kRequest + half, len - half);
+            context.parseRequest(&buf, Timestamp());
+        }
+        if (!context.gotAll()) {
+            fprintf(stderr, "parse failed\n");
+            ::exit(1);
+        }
+        const HttpRequest& req = context.request();
+        g_checksum += req.path().size() + req.getHeader("user-agent").size() + req.headers().size();
+        context.finishRequest(&buf);
+    }
+    double elapsed = timeDifference(Timestamp::now(), start);
+    fprintf(stderr, "[parse%s] %.2f allocs/request %.0f ns/request\n", split ? " split" : "",
+        static_cast<double>(g_allocs.load() - before) / requests, elapsed * 1e9 / requests);
+}
+
+void onRequest(const HttpRequest& req, HttpResponse* resp)
+{
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setBody("hello, world!\n");
+}
+
+int connectServer(uint16_t port)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+        ::perror("connect");
+        ::_exit(1);
+    }
+    int one = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return sockfd;
+}
+
+void runClient(uint16_t port, int requests)
+{
+    int sockfd = connectServer(port);
+    size_t len = ::strlen(kRequest);
+    std::string pending;
+    char buf[4096];
+    for (int i = 0; i < requests; ++i) {
+        if (::write(sockfd, kRequest, len) != static_cast<ssize_t>(len)) {
+            break;
+        }
+        size_t pos;
+        while ((pos = pending.find("hello, world!\n")) == std::string::npos) {
+            ssize_t n = ::read(sockfd, buf, sizeof buf);
+            if (n <= 0) {
+                ::_exit(1);
+            }
+            pending.append(buf, n);
+        }
+        pending.erase(0, pos + 14);
+    }
+    ::close(sockfd);
+}
+
+void benchServer(int requests)
+{
+    uint16_t port = 7904;
+    EventLoop loop;
+    HttpServer server(&loop, InetAddress(port, "127.0.0.1"), "HttpAlloc");
+    server.setHttpCallback(onRequest);
+    server.start();
+
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        runClient(port, requests);
+        ::_exit(0);
+    }
+
+    int64_t before = g_allocs.load();
+    loop.runEvery(0.01, [&loop, pid] {
+        if (::waitpid(pid, nullptr, WNOHANG) == pid) {
+            loop.quit();
+        }
+    });
+    loop.loop();
+    // 包括连接建立、定时器等与请求数无关的少量分配
+    fprintf(stderr, "[server] %.2f allocs/request\n", static_cast<double>(g_allocs.load() - before) / requests);
+}
+
+int main(int argc, char* argv[])
+{
+    int requests = argc > 1 ? ::atoi(argv[1]) : 200000;
+
+    Logger::setLogLevel(ERROR);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    benchParse(requests, false);
+    benchParse(requests, true);
+    benchServer(requests / 10);
+    return g_checksum == 0;
+}
@@ -0,0 +1,148 @@
+#include "../../http/HttpRequest.h"
+#include "../../http/HttpResponse.h"
+#include "../../http/HttpServer.h"
+
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// HTTP/1.1流水线请求的吞吐，与wrk的pipeline脚本类似
+// 每个客户端子进程在一个长连接上一次写出depth个GET请求，收齐depth个响应后再发下一批
+// 用法: ./bench depth [clients] [seconds]
+
+void onRequest(const HttpRequest& req, HttpResponse* resp)
+{
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("text/plain");
+    resp->setBody("hello, world!\n");
+}
+
+int connectServer(uint16_t port)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+        ::perror("connect");
+        ::_exit(1);
+    }
+    int one = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return sockfd;
+}
+
+// 返回收到的响应数
+int64_t runClient(uint16_t port, int depth, double seconds)
+{
+    std::string batch;
+    for (int i = 0; i < depth; ++i) {
+        batch += "GET /hello HTTP/1.1\r\nHost: localhost\r\nUser-Agent: bench\r\nAccept: */*\r\n\r\n";
+    }
+
+    int sockfd = connectServer(port);
+    int64_t responses = 0;
+    std::string pending;
+    char buf[64 * 1024];
+    Timestamp start(Timestamp::now());
+    while (timeDifference(Timestamp::now(), start) < seconds) {
+        if (::write(sockfd, batch.data(), batch.size()) != static_cast<ssize_t>(batch.size())) {
+            break;
+        }
+        // 每个响应都以固定的响应体结尾，数一数收到了几个
+        int got = 0;
+        while (got < depth) {
+            ssize_t n = ::read(sockfd, buf, sizeof buf);
+            if (n <= 0) {
+                ::close(sockfd);
+                return responses;
+            }
+            pending.append(buf, n);
+            size_t pos;
+            while ((pos = pending.find("hello, world!\n")) != std::string::npos) {
+                pending.erase(0, pos + 14);
+                ++got;
+            }
+        }
+        responses += got;
+    }
+    ::close(sockfd);
+    return responses;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s depth [clients] [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    int depth = ::atoi(argv[1]);
+    int clients = argc > 2 ? ::atoi(argv[2]) : 4;
+    double seconds = argc > 3 ? ::atof(argv[3]) : 3.0;
+    uint16_t port = 7903;
+
+    Logger::setLogLevel(ERROR);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    HttpServer server(&loop, InetAddress(port, "127.0.0.1"), "HttpPipeline");
+    server.setHttpCallback(onRequest);
+    server.start();
+
+    std::vector<pid_t> pids;
+    std::vector<int> pipes;
+    for (int i = 0; i < clients; ++i) {
+        int fds[2];
+        if (::pipe(fds) < 0) {
+            ::perror("pipe");
+            return 1;
+        }
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::close(fds[0]);
+            int64_t responses = runClient(port, depth, seconds);
+            if (::write(fds[1], &responses, sizeof responses) != sizeof responses) {
+                ::_exit(1);
+            }
+            ::_exit(0);
+        }
+        ::close(fds[1]);
+        pids.push_back(pid);
+        pipes.push_back(fds[0]);
+    }
+
+    loop.runAfter(seconds + 0.3, [&loop] { loop.quit(); });
+    loop.loop();
+
+    int64_t responses = 0;
+    for (int i = 0; i < clients; ++i) {
+        int64_t n = 0;
+        if (::read(pipes[i], &n, sizeof n) == sizeof n) {
+            responses += n;
+        }
+        ::close(pipes[i]);
+        ::waitpid(pids[i], nullptr, 0);
+    }
+
+    fprintf(stderr, "[depth=%d clients=%d] %.0f req/s\n", depth, clients, responses / seconds);
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "../../http/HttpRequest.h"
+#include "../../http/HttpResponse.h"
+#include "../../http/HttpServer.h"
+
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// HTTP POST请求体的吞吐，客户端在子进程中通过一个长连接逐个发送bodySize字节的POST请求并等待回复
+// length: Content-Length请求体  chunked: 每16KB一个chunk
+// copy: 请求体拷贝到HttpRequest中  view: 已经完整收到的请求体直接引用输入Buffer
+// 服务端回复收到的请求体长度，客户端检查是否一致
+// 用法: ./bench copy|view length|chunked [bodySize] [requests]
+
+const size_t kChunkSize = 16 * 1024;
+int64_t g_bodyBytes = 0;
+
+void onRequest(const HttpRequest& req, HttpResponse* resp)
+{
+    std::string_view body = req.body();
+    g_bodyBytes += body.size();
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setBody(std::to_string(body.size()));
+}
+
+int connectServer(uint16_t port)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+        ::perror("connect");
+        ::_exit(1);
+    }
+    int one = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return sockfd;
+}
+
+bool writeAll(int sockfd, const std::string& data)
+{
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::write(sockfd, data.data() + sent, data.size() - sent);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+// 读一个回复，返回回复体，出错返回空
+std::string readResponse(int sockfd, std::string* pending)
+{
+    for (;;) {
+        size_t headerEnd = pending->find("\r\n\r\n");
+        if (headerEnd != std::string::npos) {
+            size_t pos = pending->find("Content-Length: ");
+            size_t length = pos < headerEnd ? ::strtoul(pending->c_str() + pos + 16, nullptr, 10) : 0;
+            if (pending->size() >= headerEnd + 4 + length) {
+                std::string body = pending->substr(headerEnd + 4, length);
+                pending->erase(0, headerEnd + 4 + length);
+                return body;
+            }
+        }
+        char buf[4096];
+        ssize_t n = ::read(sockfd, buf, sizeof buf);
+        if (n <= 0) {
+            return std::string();
+        }
+        pending->append(buf, n);
+    }
+}
+
+void runClient(uint16_t port, bool chunked, size_t bodySize, int requests)
+{
+    std::string body(bodySize, 'p');
+    std::string request;
+    if (chunked) {
+        request = "POST /upload HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n";
+        for (size_t offset = 0; offset < bodySize; offset += kChunkSize) {
+            size_t len = std::min(kChunkSize, bodySize - offset);
+            char line[32];
+            snprintf(line, sizeof line, "%zx\r\n", len);
+            request += line;
+            request.append(body, offset, len);
+            request += "\r\n";
+        }
+        request += "0\r\n\r\n";
+    } else {
+        request = "POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: " + std::to_string(bodySize) + "\r\n\r\n" + body;
+    }
+
+    int sockfd = connectServer(port);
+    std::string pending;
+    std::string expected = std::to_string(bodySize);
+    for (int i = 0; i < requests; ++i) {
+        if (!writeAll(sockfd, request) || readResponse(sockfd, &pending) != expected) {
+            fprintf(stderr, "request %d failed\n", i);
+            ::_exit(1);
+        }
+    }
+    ::close(sockfd);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s copy|view length|chunked [bodySize] [requests]\n", argv[0]);
+        return 1;
+    }
+
+    bool view = ::strcmp(argv[1], "view") == 0;
+    bool chunked = ::strcmp(argv[2], "chunked") == 0;
+    size_t bodySize = argc > 3 ? ::atoi(argv[3]) : 64 * 1024;
+    int requests = argc > 4 ? ::atoi(argv[4]) : 20000;
+    uint16_t port = 7902;
+
+    Logger::setLogLevel(ERROR);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    HttpServer server(&loop, InetAddress(port, "127.0.0.1"), "HttpPost");
+    server.setHttpCallback(onRequest);
+    server.setBodyView(view);
+    server.setMaxBodySize(bodySize);
+    server.start();
+
+    Timestamp start(Timestamp::now());
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        runClient(port, chunked, bodySize, requests);
+        ::_exit(0);
+    }
+
+    // 客户端退出后停止loop
+    loop.runEvery(0.01, [&loop, pid] {
+        int status;
+        if (::waitpid(pid, &status, WNOHANG) == pid) {
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                fprintf(stderr, "client failed\n");
+            }
+            loop.quit();
+        }
+    });
+    loop.loop();
+    double elapsed = timeDifference(Timestamp::now(), start);
+
+    fprintf(stderr, "[%s %s body=%zu] requests=%d body=%lld MB time=%.3fs %.0f req/s %.0f MiB/s\n",
+        argv[1], argv[2], bodySize, requests, static_cast<long long>(g_bodyBytes >> 20), elapsed,
+        requests / elapsed, g_bodyBytes / 1048576.0 / elapsed);
+    return 0;
+}
@@ -0,0 +1,211 @@
+#include <mymuduo/Buffer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/LoadBalanceStrategy.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpConnection.h>
+#include <mymuduo/TcpServer.h>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// 偏斜负载下各负载均衡策略的短请求延迟
+// 1. 先建立一批连接，下标是loop数倍数的作为重连接保留，其余立刻断开，轮询时重连接都集中在同一个loop
+// 2. 重连接流水线发送请求'H'，服务端每个请求忙等200us并回复64KB，使所在loop一直满负荷且有待发送数据
+// 3. 再建立一批轻连接，ping-pong发送64字节请求，统计往返延迟的p50/p99
+// 用法 bench rr|lc|lpb|p2c|hash [threads]
+
+const int kHeavyWorkUs = 200;
+const size_t kHeavyReply = 64 * 1024;
+const size_t kLightSize = 64;
+const int kHeavyPipeline = 32;
+
+std::string g_heavyReply(kHeavyReply, 'h');
+std::atomic_bool g_running(true);
+
+int64_t nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    while (buf->readableBytes() > 0) {
+        if (buf->peek()[0] == 'H') {
+            buf->retrieve(1);
+            int64_t start = nowUs();
+            while (nowUs() - start < kHeavyWorkUs) {
+            }
+            conn->send(g_heavyReply);
+        } else if (buf->readableBytes() >= kLightSize) {
+            conn->send(buf->retrieveAsString(kLightSize));
+        } else {
+            break;
+        }
+    }
+}
+
+int connectTo(uint16_t port)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+        ::close(sockfd);
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return sockfd;
+}
+
+bool readFull(int sockfd, char* buf, size_t len)
+{
+    size_t n = 0;
+    while (n < len) {
+        ssize_t r = ::read(sockfd, buf + n, len - n);
+        if (r <= 0) {
+            return false;
+        }
+        n += r;
+    }
+    return true;
+}
+
+// 保持kHeavyPipeline个请求在途
+void heavyClient(int sockfd)
+{
+    std::vector<char> reply(kHeavyReply);
+    for (int i = 0; i < kHeavyPipeline; ++i) {
+        ::write(sockfd, "H", 1);
+    }
+    while (g_running && readFull(sockfd, reply.data(), reply.size())) {
+        ::write(sockfd, "H", 1);
+    }
+    ::close(sockfd);
+}
+
+void lightClient(int sockfd, std::vector<int64_t>* latencies)
+{
+    char req[kLightSize];
+    char resp[kLightSize];
+    ::memset(req, 'L', sizeof req);
+    while (g_running) {
+        int64_t start = nowUs();
+        if (::write(sockfd, req, sizeof req) != sizeof req || !readFull(sockfd, resp, sizeof resp)) {
+            break;
+        }
+        latencies->push_back(nowUs() - start);
+        ::usleep(1000);
+    }
+    ::close(sockfd);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s rr|lc|lpb|p2c|hash [threads] [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    std::string mode(argv[1]);
+    int threads = argc > 2 ? ::atoi(argv[2]) : 4;
+    int seconds = argc > 3 ? ::atoi(argv[3]) : 5;
+    uint16_t port = 7896;
+
+    LoadBalanceStrategy::Type type = LoadBalanceStrategy::kRoundRobin;
+    if (mode == "lc") {
+        type = LoadBalanceStrategy::kLeastConnections;
+    } else if (mode == "lpb") {
+        type = LoadBalanceStrategy::kLeastPendingBytes;
+    } else if (mode == "p2c") {
+        type = LoadBalanceStrategy::kPowerOfTwoChoices;
+    } else if (mode == "hash") {
+        type = LoadBalanceStrategy::kPeerHash;
+    }
+
+    Logger::setLogLevel(FATAL); // 结束时大量连接同时断开，屏蔽ERROR日志
+    ::signal(SIGPIPE, SIG_IGN); // 结束时服务端先关闭连接，客户端线程可能还在写
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port, "127.0.0.1"), "LoadBalance");
+    server.setThreadNum(threads);
+    server.setLoadBalance(type);
+    server.setMessageCallback(onMessage);
+    server.start();
+
+    std::vector<std::thread> workers;
+    std::vector<std::vector<int64_t>> latencies(threads * 4);
+
+    std::thread driver([&] {
+        // 1. 偏斜的连接分布
+        std::vector<int> heavy;
+        for (int i = 0; i < threads * 2; ++i) {
+            int sockfd = connectTo(port);
+            if (i % threads == 0) {
+                heavy.push_back(sockfd);
+            } else {
+                ::close(sockfd);
+            }
+        }
+        ::usleep(200 * 1000); // 等服务端处理完断开
+
+        // 2. 重连接开始工作
+        for (int sockfd : heavy) {
+            workers.emplace_back(heavyClient, sockfd);
+        }
+        ::usleep(300 * 1000);
+
+        // 3. 轻连接
+        for (size_t i = 0; i < latencies.size(); ++i) {
+            int sockfd = connectTo(port);
+            workers.emplace_back(lightClient, sockfd, &latencies[i]);
+        }
+
+        ::sleep(seconds);
+        g_running = false;
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    std::vector<int64_t> all;
+    for (auto& lat : latencies) {
+        all.insert(all.end(), lat.begin(), lat.end());
+    }
+    if (all.empty()) {
+        fprintf(stderr, "no samples\n");
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+    fprintf(stderr, "[%s] threads=%d samples=%zu p50=%lldus p99=%lldus max=%lldus\n",
+        mode.c_str(), threads, all.size(),
+        static_cast<long long>(all[all.size() / 2]),
+        static_cast<long long>(all[all.size() * 99 / 100]),
+        static_cast<long long>(all.back()));
+    return 0;
+}
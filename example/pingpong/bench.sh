@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# 分别使用epoll和io_uring运行pingpong测试，对比吞吐量
+# io_uring是实验性的后端，库需要用cmake -DMYMUDUO_EXPERIMENTAL_IOURING=ON编译，否则两次都是epoll
+# 用法: ./bench.sh [threads] [blocksize] [sessions] [time]
+
+threads=${1:-4}
+blocksize=${2:-16384}
+sessions=${3:-100}
+time=${4:-10}
+port=33333
+
+for backend in epoll io_uring; do
+    if [ $backend = io_uring ]; then
+        export MUDUO_USE_IOURING=1
+    else
+        unset MUDUO_USE_IOURING
+    fi
+
+    ./server 127.0.0.1 $port $threads > /dev/null &
+    srvpid=$!
+    sleep 1
+
+    ./client 127.0.0.1 $port $threads $blocksize $sessions $time | grep "^\[$backend\]"
+
+    kill $srvpid
+    wait $srvpid 2> /dev/null
+    sleep 1
+done
@@ -0,0 +1,174 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThreadPool.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpClient.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// pingpong测试的客户端
+// 每个session建立连接后发送blockSize字节，之后把收到的数据原样发回，
+// 持续timeout秒后断开所有连接，统计总吞吐量
+// 通过环境变量MUDUO_USE_IOURING选择io_uring或epoll，io_uring需要库用-DMYMUDUO_EXPERIMENTAL_IOURING=ON编译
+
+class Client;
+
+class Session : noncopyable {
+public:
+    Session(EventLoop* loop, const InetAddress& serverAddr, const std::string& name, Client* owner)
+        : client_(loop, serverAddr, name)
+        , owner_(owner)
+        , bytesRead_(0)
+        , messagesRead_(0)
+    {
+        client_.setConnectionCallback(
+            std::bind(&Session::onConnection, this, std::placeholders::_1));
+        client_.setMessageCallback(
+            std::bind(&Session::onMessage, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    }
+
+    void start() { client_.connect(); }
+    void stop() { client_.disconnect(); }
+
+    int64_t bytesRead() const { return bytesRead_; }
+    int64_t messagesRead() const { return messagesRead_; }
+
+private:
+    void onConnection(const TcpConnectionPtr& conn);
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+    {
+        ++messagesRead_;
+        bytesRead_ += buf->readableBytes();
+        conn->send(buf);
+    }
+
+    TcpClient client_;
+    Client* owner_;
+    std::atomic_int64_t bytesRead_;
+    std::atomic_int64_t messagesRead_;
+};
+
+class Client : noncopyable {
+public:
+    Client(EventLoop* loop, const InetAddress& serverAddr,
+        int blockSize, int sessionCount, int timeout, int threadCount)
+        : loop_(loop)
+        , threadPool_(loop, "pingpong-client")
+        , sessionCount_(sessionCount)
+        , timeout_(timeout)
+        , numConnected_(0)
+    {
+        loop->runAfter(timeout, std::bind(&Client::handleTimeout, this));
+        if (threadCount > 1) {
+            threadPool_.setThreadNum(threadCount);
+        }
+        threadPool_.start();
+
+        for (int i = 0; i < blockSize; ++i) {
+            message_.push_back(static_cast<char>(i % 128));
+        }
+
+        for (int i = 0; i < sessionCount; ++i) {
+            char buf[32];
+            snprintf(buf, sizeof buf, "C%05d", i);
+            Session* session = new Session(threadPool_.getNextLoop(), serverAddr, buf, this);
+            session->start();
+            sessions_.emplace_back(session);
+        }
+    }
+
+    const std::string& message() const { return message_; }
+
+    void onConnect()
+    {
+        if (++numConnected_ == sessionCount_) {
+            LOG_INFO("all connected\n");
+        }
+    }
+
+    void onDisconnect(const TcpConnectionPtr& conn)
+    {
+        if (--numConnected_ == 0) {
+            int64_t totalBytesRead = 0;
+            int64_t totalMessagesRead = 0;
+            for (const auto& session : sessions_) {
+                totalBytesRead += session->bytesRead();
+                totalMessagesRead += session->messagesRead();
+            }
+            printf("%s %ld total bytes read\n", backend(), totalBytesRead);
+            printf("%s %ld total messages read\n", backend(), totalMessagesRead);
+            printf("%s %.3f average message size\n", backend(),
+                static_cast<double>(totalBytesRead) / static_cast<double>(totalMessagesRead));
+            printf("%s %.3f MiB/s throughput\n", backend(),
+                static_cast<double>(totalBytesRead) / (timeout_ * 1024 * 1024));
+            fflush(stdout);
+            loop_->queueInloop(std::bind(&EventLoop::quit, loop_));
+        }
+    }
+
+private:
+    static const char* backend()
+    {
+        return ::getenv("MUDUO_USE_IOURING") ? "[io_uring]" : "[epoll]";
+    }
+
+    void handleTimeout()
+    {
+        LOG_INFO("stop\n");
+        for (auto& session : sessions_) {
+            session->stop();
+        }
+    }
+
+    EventLoop* loop_;
+    EventLoopThreadPool threadPool_; // 要先于sessions_构造、晚于sessions_析构
+    int sessionCount_;
+    int timeout_;
+    std::vector<std::unique_ptr<Session>> sessions_;
+    std::string message_;
+    std::atomic_int numConnected_;
+};
+
+void Session::onConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected()) {
+        conn->setTcpNoDelay(true);
+        conn->send(owner_->message());
+        owner_->onConnect();
+    } else {
+        owner_->onDisconnect(conn);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 7) {
+        fprintf(stderr, "Usage: %s <address> <port> <threads> <blocksize> <sessions> <time>\n", argv[0]);
+        return 0;
+    }
+
+    LOG_INFO("pid = %d\n", getpid());
+
+    const char* ip = argv[1];
+    uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
+    int threadCount = atoi(argv[3]);
+    int blockSize = atoi(argv[4]);
+    int sessionCount = atoi(argv[5]);
+    int timeout = atoi(argv[6]);
+
+    EventLoop loop;
+    InetAddress serverAddr(port, ip);
+
+    Client client(&loop, serverAddr, blockSize, sessionCount, timeout, threadCount);
+    loop.loop();
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpServer.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <unistd.h>
+
+// pingpong测试的服务端，收到什么就原样发回去
+// 通过环境变量MUDUO_USE_IOURING选择io_uring或epoll，io_uring需要库用-DMYMUDUO_EXPERIMENTAL_IOURING=ON编译
+class PingPongServer {
+public:
+    PingPongServer(EventLoop* loop, const InetAddress& listenAddr, int numThreads)
+        : server_(loop, listenAddr, "PingPongServer")
+    {
+        server_.setConnectionCallback(
+            std::bind(&PingPongServer::onConnection, this, std::placeholders::_1));
+        server_.setMessageCallback(
+            std::bind(&PingPongServer::onMessage, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+        server_.setThreadNum(numThreads);
+    }
+
+    void start() { server_.start(); }
+
+private:
+    void onConnection(const TcpConnectionPtr& conn)
+    {
+        if (conn->connected()) {
+            conn->setTcpNoDelay(true);
+        }
+    }
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+    {
+        conn->send(buf);
+    }
+
+    TcpServer server_;
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <address> <port> <threads>\n", argv[0]);
+        return 0;
+    }
+
+    LOG_INFO("pid = %d\n", getpid());
+
+    EventLoop loop;
+    InetAddress listenAddr(static_cast<uint16_t>(atoi(argv[2])), argv[1]);
+    PingPongServer server(&loop, listenAddr, atoi(argv[3]));
+
+    server.start();
+    loop.loop();
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+#include <mymuduo/Buffer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpClient.h>
+#include <mymuduo/TcpConnection.h>
+#include <mymuduo/TcpServer.h>
+
+#include <any>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <signal.h>
+#include <string>
+
+//
+// TCP中继 relay <listenPort> <backendIp> <backendPort> [threads]
+// 每个客户端连接对应一个Tunnel，Tunnel在同一个loop上用TcpClient连接后端，双向转发数据
+// 反压 一侧的outputBuffer_超过高水位时，对另一侧stopRead，数据留在内核缓冲区中由TCP流量控制减慢对端，
+// 积压的数据发送完(writeCompleteCallback)后再startRead，中继进程的内存占用与两端速度差无关
+//
+static const size_t kHighMark = 1024 * 1024;
+
+class Tunnel : public std::enable_shared_from_this<Tunnel>, noncopyable {
+public:
+    Tunnel(EventLoop* loop, const InetAddress& backendAddr, const TcpConnectionPtr& serverConn)
+        : client_(loop, backendAddr, serverConn->name())
+        , serverConn_(serverConn)
+    {
+    }
+
+    void setup()
+    {
+        std::weak_ptr<Tunnel> wkTunnel = shared_from_this();
+        client_.setConnectionCallback([wkTunnel](const TcpConnectionPtr& conn) {
+            if (auto tunnel = wkTunnel.lock()) {
+                tunnel->onClientConnection(conn);
+            }
+        });
+        client_.setMessageCallback([wkTunnel](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+            if (auto tunnel = wkTunnel.lock()) {
+                tunnel->onClientMessage(conn, buf);
+            }
+        });
+        serverConn_->setHighWaterMarkCallback(
+            [wkTunnel](const TcpConnectionPtr& conn, size_t bytes) {
+                if (auto tunnel = wkTunnel.lock()) {
+                    tunnel->onHighWaterMark(kServer, conn, bytes);
+                }
+            },
+            kHighMark);
+    }
+
+    void connect() { client_.connect(); }
+
+    void disconnect()
+    {
+        client_.disconnect();
+        teardown();
+    }
+
+    // 客户端发来的数据转发给后端
+    void onServerMessage(Buffer* buf)
+    {
+        if (clientConn_) {
+            clientConn_->send(buf);
+        }
+    }
+
+private:
+    enum Side { kServer, kClient };
+
+    void teardown()
+    {
+        client_.setConnectionCallback(defaultConnectionCallback);
+        client_.setMessageCallback(defaultMessageCallback);
+        if (serverConn_) {
+            serverConn_->setContext(std::any());
+            serverConn_->shutdown();
+        }
+        clientConn_.reset();
+        serverConn_.reset(); // 打破serverConn_ <-> Tunnel的循环引用
+    }
+
+    void onClientConnection(const TcpConnectionPtr& conn)
+    {
+        if (conn->connected()) {
+            conn->setTcpNoDelay(true);
+            std::weak_ptr<Tunnel> wkTunnel = shared_from_this();
+            conn->setHighWaterMarkCallback(
+                [wkTunnel](const TcpConnectionPtr& conn, size_t bytes) {
+                    if (auto tunnel = wkTunnel.lock()) {
+                        tunnel->onHighWaterMark(kClient, conn, bytes);
+                    }
+                },
+                kHighMark);
+            clientConn_ = conn;
+            serverConn_->startRead(); // 后端连上了，开始读取客户端的数据
+        } else {
+            teardown();
+        }
+    }
+
+    // 后端发来的数据转发给客户端
+    void onClientMessage(const TcpConnectionPtr& conn, Buffer* buf)
+    {
+        if (serverConn_) {
+            serverConn_->send(buf);
+        } else {
+            buf->retrieveAll();
+        }
+    }
+
+    // side一侧的发送缓冲区积压，停止读取另一侧，等side一侧的数据发完再恢复
+    void onHighWaterMark(Side side, const TcpConnectionPtr& conn, size_t bytes)
+    {
+        LOG_INFO("Tunnel %s high water mark %zu bytes, stop reading %s\n",
+            side == kServer ? "client->relay" : "relay->backend", bytes,
+            side == kServer ? "backend" : "client");
+
+        TcpConnectionPtr other = side == kServer ? clientConn_ : serverConn_;
+        if (!other) {
+            return;
+        }
+        other->stopRead();
+
+        std::weak_ptr<Tunnel> wkTunnel = shared_from_this();
+        conn->setWriteCompleteCallback([wkTunnel, side](const TcpConnectionPtr& conn) {
+            if (auto tunnel = wkTunnel.lock()) {
+                tunnel->onWriteComplete(side, conn);
+            }
+        });
+    }
+
+    void onWriteComplete(Side side, const TcpConnectionPtr& conn)
+    {
+        TcpConnectionPtr other = side == kServer ? clientConn_ : serverConn_;
+        if (other) {
+            other->startRead();
+        }
+        conn->setWriteCompleteCallback(WriteCompleteCallback());
+    }
+
+    TcpClient client_;
+    TcpConnectionPtr serverConn_;
+    TcpConnectionPtr clientConn_;
+};
+
+using TunnelPtr = std::shared_ptr<Tunnel>;
+
+class RelayServer {
+public:
+    RelayServer(EventLoop* loop, const InetAddress& listenAddr, const InetAddress& backendAddr, int threads)
+        : server_(loop, listenAddr, "RelayServer")
+        , backendAddr_(backendAddr)
+    {
+        server_.setConnectionCallback(std::bind(&RelayServer::onConnection, this, std::placeholders::_1));
+        server_.setMessageCallback(std::bind(&RelayServer::onMessage, this,
+            std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+        server_.setThreadNum(threads);
+    }
+
+    void start() { server_.start(); }
+
+private:
+    void onConnection(const TcpConnectionPtr& conn)
+    {
+        if (conn->connected()) {
+            conn->setTcpNoDelay(true);
+            conn->stopRead(); // 后端还没连上，先不读取客户端的数据
+            TunnelPtr tunnel = std::make_shared<Tunnel>(conn->getLoop(), backendAddr_, conn);
+            tunnel->setup();
+            tunnel->connect();
+            conn->setContext(tunnel);
+        } else if (conn->getContext().has_value()) {
+            TunnelPtr tunnel = std::any_cast<TunnelPtr>(conn->getContext());
+            tunnel->disconnect();
+        }
+    }
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp time)
+    {
+        if (conn->getContext().has_value()) {
+            std::any_cast<const TunnelPtr&>(conn->getContext())->onServerMessage(buf);
+        }
+    }
+
+    TcpServer server_;
+    InetAddress backendAddr_;
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4) {
+        printf("Usage: %s <listenPort> <backendIp> <backendPort> [threads]\n", argv[0]);
+        return 0;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    Logger::setLogLevel(ERROR);
+
+    uint16_t listenPort = static_cast<uint16_t>(atoi(argv[1]));
+    InetAddress backendAddr(static_cast<uint16_t>(atoi(argv[3])), argv[2]);
+    int threads = argc > 4 ? atoi(argv[4]) : 4;
+
+    EventLoop loop;
+    RelayServer server(&loop, InetAddress(listenPort), backendAddr, threads);
+    server.start();
+    loop.loop();
+
+    return 0;
+}
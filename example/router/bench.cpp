@@ -0,0 +1,152 @@
+#include "../../http/HttpRequest.h"
+#include "../../http/HttpResponse.h"
+#include "../../http/Router.h"
+
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 路由个数从10增加到1000时每次匹配的耗时，对比Router的基数树和逐个路由比较的线性查找
+// 路由是REST风格的 /api/v1/resN  /api/v1/resN/:id  /api/v1/resN/:id/items/:item  /assetsN/*path
+// 替换全局operator new统计匹配过程中的内存分配次数
+// 用法: ./bench [matches]
+
+std::atomic<int64_t> g_allocs(0);
+
+void* operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+int64_t g_hits = 0;
+
+void onRoute(const HttpRequest&, const RouteParams& params, HttpResponse*)
+{
+    g_hits += params.size() + 1;
+}
+
+// 线性查找: 逐个路由按/分段比较，相当于if-else链
+bool matchLinear(std::string_view pattern, std::string_view path, RouteParams* params)
+{
+    while (!pattern.empty() && !path.empty()) {
+        if (pattern[0] == '*') {
+            return params->push(pattern.substr(1), path);
+        }
+        size_t pend = pattern.find('/', 1);
+        size_t send = path.find('/', 1);
+        std::string_view pseg = pattern.substr(0, pend);
+        std::string_view sseg = path.substr(0, send);
+        if (pseg.size() > 1 && pseg[1] == ':') {
+            if (sseg.size() <= 1 || !params->push(pseg.substr(2), sseg.substr(1))) {
+                return false;
+            }
+        } else if (pseg.size() > 1 && pseg[1] == '*') {
+            return params->push(pseg.substr(2), path.substr(1));
+        } else if (pseg != sseg) {
+            return false;
+        }
+        pattern.remove_prefix(pseg.size());
+        path.remove_prefix(sseg.size());
+    }
+    return pattern.empty() && path.empty();
+}
+
+void run(int numRoutes, int matches)
+{
+    Router router;
+    std::vector<std::string> patterns;
+    for (int i = 0; patterns.size() < static_cast<size_t>(numRoutes); ++i) {
+        std::string res = "/api/v1/res" + std::to_string(i);
+        patterns.push_back(res);
+        patterns.push_back(res + "/:id");
+        patterns.push_back(res + "/:id/items/:item");
+        patterns.push_back("/assets" + std::to_string(i) + "/*path");
+    }
+    patterns.resize(numRoutes);
+    for (const std::string& pattern : patterns) {
+        router.get(pattern, onRoute);
+    }
+
+    // 请求路径均匀地落在所有路由上
+    std::vector<std::string> paths;
+    for (int i = 0; i < numRoutes; ++i) {
+        int res = i / 4;
+        switch (i % 4) {
+        case 0:
+            paths.push_back("/api/v1/res" + std::to_string(res));
+            break;
+        case 1:
+            paths.push_back("/api/v1/res" + std::to_string(res) + "/12345");
+            break;
+        case 2:
+            paths.push_back("/api/v1/res" + std::to_string(res) + "/12345/items/678");
+            break;
+        default:
+            paths.push_back("/assets" + std::to_string(res) + "/css/site.min.css");
+            break;
+        }
+    }
+
+    HttpRequest req;
+    int64_t before = g_allocs.load();
+    Timestamp start(Timestamp::now());
+    for (int i = 0; i < matches; ++i) {
+        RouteParams params;
+        const Router::Handler* handler = router.match(HttpRequest::kGet, paths[i % paths.size()], &params);
+        if (handler) {
+            (*handler)(req, params, nullptr);
+        }
+    }
+    double tree = timeDifference(Timestamp::now(), start);
+    int64_t treeAllocs = g_allocs.load() - before;
+
+    start = Timestamp::now();
+    for (int i = 0; i < matches; ++i) {
+        const std::string& path = paths[i % paths.size()];
+        for (const std::string& pattern : patterns) {
+            RouteParams params;
+            if (matchLinear(pattern, path, &params)) {
+                onRoute(req, params, nullptr);
+                break;
+            }
+        }
+    }
+    double linear = timeDifference(Timestamp::now(), start);
+
+    fprintf(stderr, "[routes=%4d] radix %6.0f ns/match (%.2f allocs/match)   linear %8.0f ns/match\n",
+        numRoutes, tree * 1e9 / matches, static_cast<double>(treeAllocs) / matches, linear * 1e9 / matches);
+}
+
+int main(int argc, char* argv[])
+{
+    int matches = argc > 1 ? ::atoi(argv[1]) : 200000;
+    Logger::setLogLevel(ERROR);
+
+    for (int routes : { 10, 100, 500, 1000 }) {
+        run(routes, matches);
+    }
+    return g_hits == 0;
+}
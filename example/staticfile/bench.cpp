@@ -0,0 +1,246 @@
+#include "../../http/HttpRequest.h"
+#include "../../http/HttpResponse.h"
+#include "../../http/HttpServer.h"
+#include "../../http/StaticFileHandler.h"
+
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// 静态文件服务的吞吐，文件中90%是4KB的小文件，10%是1MB的大文件
+// body:     每个请求把文件read进HttpResponse::body
+// sendfile: StaticFileHandler不缓存，每个请求open/fstat/close，sendfile发送
+// cache:    StaticFileHandler缓存fd和stat结果
+// 每个客户端子进程在一个长连接上依次请求随机的文件
+// 用法: ./bench body|sendfile|cache [clients] [seconds] [threads]
+
+const int kSmallFiles = 180;
+const int kLargeFiles = 20;
+const size_t kSmallSize = 4 * 1024;
+const size_t kLargeSize = 1024 * 1024;
+
+std::string gRoot;
+
+std::string fileName(int i)
+{
+    char buf[32];
+    snprintf(buf, sizeof buf, i < kSmallFiles ? "small%d.txt" : "large%d.bin", i);
+    return buf;
+}
+
+void createFiles()
+{
+    char dir[] = "/tmp/staticfileXXXXXX";
+    if (::mkdtemp(dir) == nullptr) {
+        ::perror("mkdtemp");
+        ::exit(1);
+    }
+    gRoot = dir;
+
+    std::string data(kLargeSize, 'x');
+    for (int i = 0; i < kSmallFiles + kLargeFiles; ++i) {
+        std::string path = gRoot + "/" + fileName(i);
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        size_t size = i < kSmallFiles ? kSmallSize : kLargeSize;
+        if (fd < 0 || ::write(fd, data.data(), size) != static_cast<ssize_t>(size)) {
+            ::perror("write");
+            ::exit(1);
+        }
+        ::close(fd);
+    }
+}
+
+void removeFiles()
+{
+    for (int i = 0; i < kSmallFiles + kLargeFiles; ++i) {
+        ::unlink((gRoot + "/" + fileName(i)).c_str());
+    }
+    ::rmdir(gRoot.c_str());
+}
+
+// 旧的做法，整个文件读进响应体
+void onReadBody(const HttpRequest& req, HttpResponse* resp)
+{
+    std::string path = gRoot + std::string(req.path());
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) < 0) {
+        resp->setStatusCode(HttpResponse::k404NotFound);
+        resp->setStatusMessage("Not Found");
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return;
+    }
+    std::string body(st.st_size, '\0');
+    ssize_t n = ::read(fd, &body[0], body.size());
+    ::close(fd);
+    body.resize(n > 0 ? n : 0);
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("application/octet-stream");
+    resp->setBody(body);
+}
+
+int connectServer(uint16_t port)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+        ::perror("connect");
+        ::_exit(1);
+    }
+    int one = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return sockfd;
+}
+
+struct ClientResult {
+    int64_t responses;
+    int64_t bytes;
+};
+
+ClientResult runClient(uint16_t port, double seconds, unsigned seed)
+{
+    std::vector<std::string> requests;
+    for (int i = 0; i < kSmallFiles + kLargeFiles; ++i) {
+        requests.push_back("GET /" + fileName(i) + " HTTP/1.1\r\nHost: localhost\r\nAccept: */*\r\n\r\n");
+    }
+
+    int sockfd = connectServer(port);
+    ClientResult result = { 0, 0 };
+    std::vector<char> buf(256 * 1024);
+    ::srand(seed);
+    Timestamp start(Timestamp::now());
+    while (timeDifference(Timestamp::now(), start) < seconds) {
+        // 90%的请求是小文件
+        int i = ::rand() % 10 == 0 ? kSmallFiles + ::rand() % kLargeFiles : ::rand() % kSmallFiles;
+        const std::string& request = requests[i];
+        if (::write(sockfd, request.data(), request.size()) != static_cast<ssize_t>(request.size())) {
+            break;
+        }
+
+        // 读到报文头结束，按Content-Length读完响应体
+        std::string header;
+        size_t bodyReceived = 0;
+        size_t headerEnd = std::string::npos;
+        while (headerEnd == std::string::npos) {
+            ssize_t n = ::read(sockfd, buf.data(), buf.size());
+            if (n <= 0) {
+                ::close(sockfd);
+                return result;
+            }
+            header.append(buf.data(), n);
+            headerEnd = header.find("\r\n\r\n");
+        }
+        bodyReceived = header.size() - headerEnd - 4;
+        size_t pos = header.find("Content-Length: ");
+        size_t contentLength = pos < headerEnd ? ::strtoul(header.c_str() + pos + 16, nullptr, 10) : 0;
+        while (bodyReceived < contentLength) {
+            ssize_t n = ::read(sockfd, buf.data(), buf.size());
+            if (n <= 0) {
+                ::close(sockfd);
+                return result;
+            }
+            bodyReceived += n;
+        }
+        ++result.responses;
+        result.bytes += contentLength;
+    }
+    ::close(sockfd);
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s body|sendfile|cache [clients] [seconds] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    std::string mode = argv[1];
+    int clients = argc > 2 ? ::atoi(argv[2]) : 4;
+    double seconds = argc > 3 ? ::atof(argv[3]) : 3.0;
+    int threads = argc > 4 ? ::atoi(argv[4]) : 0;
+    uint16_t port = 7904;
+
+    Logger::setLogLevel(ERROR);
+    ::signal(SIGPIPE, SIG_IGN);
+    createFiles();
+
+    StaticFileHandler files(gRoot, mode == "cache" ? StaticFileHandler::kDefaultCacheSize : 0);
+    EventLoop loop;
+    HttpServer server(&loop, InetAddress(port, "127.0.0.1"), "StaticFile");
+    if (mode == "body") {
+        server.setHttpCallback(onReadBody);
+    } else {
+        server.setHttpCallback([&files](const HttpRequest& req, HttpResponse* resp) { files(req, resp); });
+    }
+    server.setThreadNum(threads);
+    server.start();
+
+    std::vector<pid_t> pids;
+    std::vector<int> pipes;
+    for (int i = 0; i < clients; ++i) {
+        int fds[2];
+        if (::pipe(fds) < 0) {
+            ::perror("pipe");
+            return 1;
+        }
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::close(fds[0]);
+            ClientResult result = runClient(port, seconds, i + 1);
+            if (::write(fds[1], &result, sizeof result) != sizeof result) {
+                ::_exit(1);
+            }
+            ::_exit(0);
+        }
+        ::close(fds[1]);
+        pids.push_back(pid);
+        pipes.push_back(fds[0]);
+    }
+
+    loop.runAfter(seconds + 0.3, [&loop] { loop.quit(); });
+    loop.loop();
+
+    ClientResult total = { 0, 0 };
+    for (int i = 0; i < clients; ++i) {
+        ClientResult result = { 0, 0 };
+        if (::read(pipes[i], &result, sizeof result) == sizeof result) {
+            total.responses += result.responses;
+            total.bytes += result.bytes;
+        }
+        ::close(pipes[i]);
+        ::waitpid(pids[i], nullptr, 0);
+    }
+    removeFiles();
+
+    StaticFileStats stats = files.stats();
+    fprintf(stderr, "[%-8s clients=%d] %8.0f req/s %8.1f MB/s  (cache hits=%lld revalidations=%lld opens=%lld)\n",
+        mode.c_str(), clients, total.responses / seconds, total.bytes / seconds / 1024 / 1024,
+        static_cast<long long>(stats.hits), static_cast<long long>(stats.revalidations),
+        static_cast<long long>(stats.misses));
+    return 0;
+}
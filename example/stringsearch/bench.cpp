@@ -0,0 +1,171 @@
+#include "../../http/HttpContext.h"
+
+#include <mymuduo/Buffer.h>
+#include <mymuduo/StringSearch.h>
+#include <mymuduo/Timestamp.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// 在1KB到8KB的HTTP请求头上对比分隔符查找的耗时
+// lines: 逐行查找\r\n和:，即HttpContext解析请求头的查找部分
+// double-crlf: 查找请求头结尾的\r\n\r\n
+// parse: 完整的HttpContext::parseRequest，包括把请求行和请求头解析成指向输入Buffer的string_view
+// std::search是改动之前Buffer::findCRLF的实现
+
+const char* kHeaderNames[] = {
+    "Host", "User-Agent", "Accept", "Accept-Language", "Accept-Encoding", "Referer",
+    "Cookie", "X-Forwarded-For", "X-Request-Id", "Cache-Control", "Sec-Fetch-Mode", "Authorization",
+};
+
+// 生成大约size字节的请求头，Cookie之类的长值和短值混合
+std::string makeHeaders(size_t size)
+{
+    std::string req = "GET /api/v1/items/123456?fields=name,price&sort=desc HTTP/1.1\r\n";
+    unsigned seed = 12345;
+    int i = 0;
+    while (req.size() + 4 < size) {
+        seed = seed * 1103515245 + 12345;
+        size_t nameIndex = i % (sizeof kHeaderNames / sizeof kHeaderNames[0]);
+        std::string name = kHeaderNames[nameIndex];
+        if (i >= static_cast<int>(sizeof kHeaderNames / sizeof kHeaderNames[0])) {
+            name = "X-Custom-Header-" + std::to_string(i);
+        }
+        size_t valueLen = (nameIndex == 6 || nameIndex == 1) ? 120 + seed % 200 : 8 + seed % 40;
+        valueLen = std::min(valueLen, size - req.size());
+        std::string value;
+        for (size_t j = 0; j < valueLen; ++j) {
+            value.push_back(static_cast<char>('a' + (seed >> (j % 16)) % 26));
+        }
+        req += name + ": " + value + "\r\n";
+        ++i;
+    }
+    req += "\r\n";
+    return req;
+}
+
+const char* findCRLFStdSearch(const char* begin, const char* end)
+{
+    static const char kCRLF[] = "\r\n";
+    const char* crlf = std::search(begin, end, kCRLF, kCRLF + 2);
+    return crlf == end ? nullptr : crlf;
+}
+
+// 逐行查找\r\n和:，返回找到的:的个数，防止被编译器优化掉
+template <typename FindCRLF, typename FindByte>
+int scanLines(const std::string& req, FindCRLF findCRLF, FindByte findByte)
+{
+    int colons = 0;
+    const char* p = req.data();
+    const char* end = p + req.size();
+    while (const char* crlf = findCRLF(p, end)) {
+        if (findByte(p, crlf, ':')) {
+            ++colons;
+        }
+        p = crlf + 2;
+    }
+    return colons;
+}
+
+// 随机数据上对比各实现与逐字节实现的结果
+bool verify()
+{
+    std::vector<StringSearch::Implementation> impls = { StringSearch::kSse2, StringSearch::kAvx2 };
+    std::string data(4096, 'x');
+    unsigned seed = 1;
+    for (int round = 0; round < 20000; ++round) {
+        size_t len = seed % 200;
+        for (size_t i = 0; i < len; ++i) {
+            seed = seed * 1103515245 + 12345;
+            const char alphabet[] = "\r\n\r\n:a ";
+            data[i] = alphabet[(seed >> 16) % 7];
+        }
+        seed = seed * 1103515245 + 12345;
+        size_t offset = seed % 4;
+        const char* begin = data.data() + std::min(offset, len);
+        const char* end = data.data() + len;
+
+        StringSearch::setImplementation(StringSearch::kScalar);
+        const char* crlf = StringSearch::findCRLF(begin, end);
+        const char* dcrlf = StringSearch::findDoubleCRLF(begin, end);
+        const char* colon = StringSearch::findByte(begin, end, ':');
+        for (StringSearch::Implementation impl : impls) {
+            if (!StringSearch::setImplementation(impl)) {
+                continue;
+            }
+            if (StringSearch::findCRLF(begin, end) != crlf
+                || StringSearch::findDoubleCRLF(begin, end) != dcrlf
+                || StringSearch::findByte(begin, end, ':') != colon) {
+                fprintf(stderr, "mismatch: %s len=%zu\n", StringSearch::implementationName(impl), len);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Func>
+double nsPerOp(int iterations, Func func)
+{
+    Timestamp start(Timestamp::now());
+    for (int i = 0; i < iterations; ++i) {
+        func();
+    }
+    return timeDifference(Timestamp::now(), start) * 1e9 / iterations;
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? ::atoi(argv[1]) : 20000;
+
+    StringSearch::Implementation best = StringSearch::implementation();
+    if (!verify()) {
+        return 1;
+    }
+    printf("selected implementation: %s, verify ok\n", StringSearch::implementationName(best));
+
+    volatile int sink = 0;
+    const size_t sizes[] = { 1024, 2048, 4096, 8192 };
+    for (size_t size : sizes) {
+        std::string req = makeHeaders(size);
+        printf("\nheaders %zu bytes, %d lines\n", req.size(), scanLines(req, findCRLFStdSearch, StringSearch::findByte) + 1);
+
+        double ns = nsPerOp(iterations, [&] {
+            sink += scanLines(req, findCRLFStdSearch, [](const char* b, const char* e, char c) {
+                const char* p = std::find(b, e, c);
+                return p == e ? nullptr : p;
+            });
+        });
+        printf("  %-8s lines %8.0f ns  %6.2f GB/s\n", "std", ns, req.size() / ns);
+
+        const StringSearch::Implementation impls[] = { StringSearch::kScalar, StringSearch::kSse2, StringSearch::kAvx2 };
+        for (StringSearch::Implementation impl : impls) {
+            if (!StringSearch::setImplementation(impl)) {
+                continue;
+            }
+            double lines = nsPerOp(iterations, [&] {
+                sink += scanLines(req, StringSearch::findCRLF, StringSearch::findByte);
+            });
+            double dcrlf = nsPerOp(iterations, [&] {
+                sink += StringSearch::findDoubleCRLF(req.data(), req.data() + req.size()) != nullptr;
+            });
+            Buffer buf;
+            double parse = nsPerOp(iterations / 4, [&] {
+                HttpContext context;
+                buf.append(req.data(), req.size());
+                context.parseRequest(&buf, Timestamp());
+                sink += context.gotAll();
+                buf.retrieveAll();
+            });
+            printf("  %-8s lines %8.0f ns  %6.2f GB/s | double-crlf %6.0f ns | parse %8.0f ns\n",
+                StringSearch::implementationName(impl), lines, req.size() / lines, dcrlf, parse);
+        }
+    }
+
+    StringSearch::setImplementation(best);
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/Timestamp.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// N个生产者线程向同一个loop投递回调，统计每秒投递的回调数
+// lockfree: EventLoop::queueInloop 无锁队列 + 唤醒合并
+// mutex:    原来的实现 mutex保护的vector + 每次投递都写一次eventfd
+
+// 原来queueInloop的实现，单独用一个消费者线程阻塞读eventfd来模拟loop
+class MutexTaskQueue {
+public:
+    using Functor = std::function<void()>;
+
+    MutexTaskQueue()
+        : wakeupFd_(::eventfd(0, EFD_CLOEXEC))
+        , quit_(false)
+        , thread_(&MutexTaskQueue::loop, this)
+    {
+    }
+
+    ~MutexTaskQueue()
+    {
+        queueInloop([this] { quit_ = true; });
+        thread_.join();
+        ::close(wakeupFd_);
+    }
+
+    void queueInloop(Functor cb)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            pendingFunctors_.emplace_back(std::move(cb));
+        }
+        uint64_t one = 1;
+        ssize_t n = ::write(wakeupFd_, &one, sizeof one);
+        (void)n;
+    }
+
+private:
+    void loop()
+    {
+        while (!quit_) {
+            uint64_t one;
+            ssize_t n = ::read(wakeupFd_, &one, sizeof one);
+            (void)n;
+
+            std::vector<Functor> functors;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                functors.swap(pendingFunctors_);
+            }
+            for (const Functor& functor : functors) {
+                functor();
+            }
+        }
+    }
+
+    int wakeupFd_;
+    bool quit_;
+    std::mutex mutex_;
+    std::vector<Functor> pendingFunctors_;
+    std::thread thread_;
+};
+
+// 所有回调执行完后通知主线程
+class Counter {
+public:
+    explicit Counter(int64_t total)
+        : total_(total)
+        , count_(0)
+    {
+    }
+
+    void increment()
+    {
+        if (++count_ == total_) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.notify_one();
+        }
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this] { return count_ == total_; });
+    }
+
+private:
+    const int64_t total_;
+    int64_t count_; // 只在消费者线程中修改
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+
+template <typename Post>
+static void run(const char* name, int numProducers, int postsPerProducer, Post post)
+{
+    Counter counter(static_cast<int64_t>(numProducers) * postsPerProducer);
+
+    Timestamp start = Timestamp::now();
+    std::vector<std::thread> producers;
+    for (int i = 0; i < numProducers; ++i) {
+        producers.emplace_back([&] {
+            for (int j = 0; j < postsPerProducer; ++j) {
+                post([&counter] { counter.increment(); });
+            }
+        });
+    }
+    for (std::thread& t : producers) {
+        t.join();
+    }
+    counter.wait();
+
+    double seconds = timeDifference(Timestamp::now(), start);
+    double total = static_cast<double>(numProducers) * postsPerProducer;
+    printf("%-8s producers %2d %10.0f posts/s\n", name, numProducers, total / seconds);
+}
+
+int main(int argc, char* argv[])
+{
+    int maxProducers = argc > 1 ? atoi(argv[1]) : 8;
+    int postsPerProducer = argc > 2 ? atoi(argv[2]) : 200000;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    MutexTaskQueue mutexQueue;
+
+    for (int n = 1; n <= maxProducers; n *= 2) {
+        run("lockfree", n, postsPerProducer, [loop](EventLoop::Functor cb) { loop->queueInloop(std::move(cb)); });
+        run("mutex", n, postsPerProducer, [&mutexQueue](EventLoop::Functor cb) { mutexQueue.queueInloop(std::move(cb)); });
+    }
+
+    return 0;
+}
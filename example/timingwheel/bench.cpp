@@ -0,0 +1,92 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/Timestamp.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+// 对比TimerQueue中std::set实现的定时器与时间轮粗粒度定时器
+// 模拟每个连接一个空闲超时定时器，每收到一条消息刷新一次
+// std::set路径的刷新只能cancel后重新runAfter，时间轮路径使用touch
+// 所有操作都在loop线程中直接执行，不需要启动loop
+
+static void report(const char* name, const char* op, int n, Timestamp start)
+{
+    double seconds = timeDifference(Timestamp::now(), start);
+    printf("%-8s %-8s %8d ops %8.3f s %8.1f ns/op\n", name, op, n, seconds, seconds * 1e9 / n);
+}
+
+static void benchSet(EventLoop* loop, const std::vector<double>& delays, int rounds)
+{
+    int n = static_cast<int>(delays.size());
+    std::vector<TimerId> ids(n);
+
+    Timestamp start = Timestamp::now();
+    for (int i = 0; i < n; ++i) {
+        ids[i] = loop->runAfter(delays[i], [] {});
+    }
+    report("set", "insert", n, start);
+
+    start = Timestamp::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < n; ++i) {
+            loop->cancel(ids[i]);
+            ids[i] = loop->runAfter(delays[i], [] {});
+        }
+    }
+    report("set", "refresh", n * rounds, start);
+
+    start = Timestamp::now();
+    for (int i = 0; i < n; ++i) {
+        loop->cancel(ids[i]);
+    }
+    report("set", "cancel", n, start);
+}
+
+static void benchWheel(EventLoop* loop, const std::vector<double>& delays, int rounds)
+{
+    int n = static_cast<int>(delays.size());
+    std::vector<TimerId> ids(n);
+
+    Timestamp start = Timestamp::now();
+    for (int i = 0; i < n; ++i) {
+        ids[i] = loop->runAfterCoarse(delays[i], [] {});
+    }
+    report("wheel", "insert", n, start);
+
+    start = Timestamp::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < n; ++i) {
+            loop->touch(ids[i]);
+        }
+    }
+    report("wheel", "refresh", n * rounds, start);
+
+    start = Timestamp::now();
+    for (int i = 0; i < n; ++i) {
+        loop->cancel(ids[i]);
+    }
+    report("wheel", "cancel", n, start);
+}
+
+int main(int argc, char* argv[])
+{
+    int numTimers = argc > 1 ? atoi(argv[1]) : 1000 * 1000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 3;
+
+    // 空闲超时分布在10s到70s之间
+    std::mt19937 gen(12345);
+    std::uniform_real_distribution<double> dist(10.0, 70.0);
+    std::vector<double> delays(numTimers);
+    for (double& delay : delays) {
+        delay = dist(gen);
+    }
+
+    EventLoop loop;
+    benchSet(&loop, delays, rounds);
+    benchWheel(&loop, delays, rounds);
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+#include <mymuduo/UdpServer.h>
+#include <mymuduo/UdpSocket.h>
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// UDP回显服务器的每秒数据报数(pps)，对比每次recvmmsg/sendmmsg处理1个和batch个数据报
+// 每个客户端是一个子进程，用connect过的UDP socket一次发出window个数据报，收齐回复(或超时)再发下一批，
+// 不同的源端口让kReusePortPerLoop模式下的数据报分散到各个loop
+// 用法: ./bench batch [threads] [clients] [seconds] [size]
+
+const int kWindow = 64;
+
+int connectServer(uint16_t port)
+{
+    int sockfd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+        ::perror("connect");
+        ::_exit(1);
+    }
+    // 丢包时不会一直阻塞
+    struct timeval tv = { 0, 100 * 1000 };
+    ::setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    return sockfd;
+}
+
+// 返回收到的回复数
+int64_t runClient(uint16_t port, double seconds, size_t size)
+{
+    int sockfd = connectServer(port);
+    std::string payload(size, 'u');
+    std::vector<char> recvBuf(kWindow * 2048);
+    struct mmsghdr msgs[kWindow];
+    struct iovec iovecs[kWindow];
+
+    int64_t replies = 0;
+    Timestamp start(Timestamp::now());
+    while (timeDifference(Timestamp::now(), start) < seconds) {
+        for (int i = 0; i < kWindow; ++i) {
+            iovecs[i].iov_base = const_cast<char*>(payload.data());
+            iovecs[i].iov_len = payload.size();
+            ::memset(&msgs[i].msg_hdr, 0, sizeof msgs[i].msg_hdr);
+            msgs[i].msg_hdr.msg_iov = &iovecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = ::sendmmsg(sockfd, msgs, kWindow, 0);
+        if (sent <= 0) {
+            continue;
+        }
+
+        int received = 0;
+        while (received < sent) {
+            for (int i = 0; i < kWindow; ++i) {
+                iovecs[i].iov_base = recvBuf.data() + i * 2048;
+                iovecs[i].iov_len = 2048;
+                ::memset(&msgs[i].msg_hdr, 0, sizeof msgs[i].msg_hdr);
+                msgs[i].msg_hdr.msg_iov = &iovecs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            int n = ::recvmmsg(sockfd, msgs, sent - received, MSG_WAITFORONE, nullptr);
+            if (n <= 0) {
+                break; // 超时，剩下的数据报丢了
+            }
+            received += n;
+        }
+        replies += received;
+    }
+    ::close(sockfd);
+    return replies;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s batch [threads] [clients] [seconds] [size]\n", argv[0]);
+        return 1;
+    }
+
+    int batch = ::atoi(argv[1]);
+    int threads = argc > 2 ? ::atoi(argv[2]) : 0;
+    int clients = argc > 3 ? ::atoi(argv[3]) : 4;
+    double seconds = argc > 4 ? ::atof(argv[4]) : 3.0;
+    size_t size = argc > 5 ? ::atoi(argv[5]) : 64;
+    uint16_t port = 7901;
+
+    Logger::setLogLevel(ERROR);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    UdpServer server(&loop, InetAddress(port, "127.0.0.1"), "UdpBench", UdpServer::kReusePortPerLoop);
+    server.setThreadNum(threads);
+    server.setBatchSize(batch);
+    server.setMessageCallback([](const UdpSocketPtr& socket, const char* data, size_t len, const InetAddress& peer, Timestamp) {
+        socket->sendTo(data, len, peer);
+    });
+    server.start();
+
+    std::vector<pid_t> pids;
+    std::vector<int> pipes;
+    for (int i = 0; i < clients; ++i) {
+        int fds[2];
+        if (::pipe(fds) < 0) {
+            ::perror("pipe");
+            return 1;
+        }
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::close(fds[0]);
+            int64_t replies = runClient(port, seconds, size);
+            if (::write(fds[1], &replies, sizeof replies) != sizeof replies) {
+                ::_exit(1);
+            }
+            ::_exit(0);
+        }
+        ::close(fds[1]);
+        pids.push_back(pid);
+        pipes.push_back(fds[0]);
+    }
+
+    // 客户端在seconds秒后停止，多等一会儿让最后一批回复发完
+    loop.runAfter(seconds + 0.3, [&loop] { loop.quit(); });
+    loop.loop();
+
+    int64_t replies = 0;
+    for (int i = 0; i < clients; ++i) {
+        int64_t n = 0;
+        if (::read(pipes[i], &n, sizeof n) == sizeof n) {
+            replies += n;
+        }
+        ::close(pipes[i]);
+        ::waitpid(pids[i], nullptr, 0);
+    }
+
+    UdpStats stats = server.stats();
+    fprintf(stderr, "[batch=%d threads=%d clients=%d size=%zu] echo=%.0f pps received=%llu (%.1f per recvmmsg) sent=%llu (%.1f per sendmmsg) dropped=%llu\n",
+        batch, threads, clients, size, replies / seconds, static_cast<unsigned long long>(stats.received),
+        stats.recvCalls > 0 ? static_cast<double>(stats.received) / stats.recvCalls : 0.0,
+        static_cast<unsigned long long>(stats.sent),
+        stats.sendCalls > 0 ? static_cast<double>(stats.sent) / stats.sendCalls : 0.0,
+        static_cast<unsigned long long>(stats.dropped));
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpConnection.h>
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <signal.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// 对比普通拷贝发送和MSG_ZEROCOPY发送msgSize字节的共享payload时服务端的吞吐和CPU时间
+// 服务端每次写完成再发下一批，客户端在子进程中读取并丢弃
+// 发往loopback时内核总是退化为拷贝(completions中copied == completions)，要在真实网卡上测试才能看到收益:
+//   ./bench zerocopy 65536 1024 0.0.0.0 自己作为服务端，另一台机器上 nc host 7900 > /dev/null
+
+int64_t g_totalBytes = 0;
+int64_t g_sentBytes = 0;
+std::shared_ptr<const std::string> g_payload;
+const int kBatch = 4; // 每次写完成后发送的块数
+
+void sendBatch(const TcpConnectionPtr& conn)
+{
+    for (int i = 0; i < kBatch && g_sentBytes < g_totalBytes; ++i) {
+        conn->send(g_payload);
+        g_sentBytes += g_payload->size();
+    }
+    if (g_sentBytes >= g_totalBytes) {
+        conn->shutdown();
+    }
+}
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected()) {
+        sendBatch(conn);
+    } else {
+        const ChainBuffer::ZeroCopyStats& stats = conn->zeroCopyStats();
+        fprintf(stderr, "  zerocopy sends=%lld bytes=%lld MB completions=%lld copied=%lld\n",
+            static_cast<long long>(stats.sends), static_cast<long long>(stats.bytes >> 20),
+            static_cast<long long>(stats.completions), static_cast<long long>(stats.copied));
+        conn->getLoop()->quit();
+    }
+}
+
+void onWriteComplete(const TcpConnectionPtr& conn)
+{
+    if (g_sentBytes < g_totalBytes) {
+        sendBatch(conn);
+    }
+}
+
+void runClient(const char* ip, uint16_t port)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr(ip);
+    if (::connect(sockfd, (struct sockaddr*)&addr, sizeof addr) < 0) {
+        ::perror("connect");
+        ::_exit(1);
+    }
+    char buf[256 * 1024];
+    while (::read(sockfd, buf, sizeof buf) > 0) {
+    }
+    ::close(sockfd);
+}
+
+double cpuSeconds()
+{
+    struct rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s copy|zerocopy msgSize [MB] [listenIp]\n", argv[0]);
+        return 1;
+    }
+
+    bool zeroCopy = ::strcmp(argv[1], "zerocopy") == 0;
+    size_t msgSize = ::atoi(argv[2]);
+    g_totalBytes = (argc > 3 ? ::atoll(argv[3]) : 1024) * 1024 * 1024;
+    const char* listenIp = argc > 4 ? argv[4] : "127.0.0.1";
+    uint16_t port = 7900;
+    g_payload = std::make_shared<const std::string>(msgSize, 'z');
+
+    Logger::setLogLevel(ERROR);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port, listenIp), "ZeroCopy");
+    server.setConnectionCallback(onConnection);
+    server.setWriteCompleteCallback(onWriteComplete);
+    // 阈值设为0，所有发送都走MSG_ZEROCOPY，由msgSize决定大小
+    server.setZeroCopy(zeroCopy, 0);
+    server.start();
+
+    bool remote = ::strcmp(listenIp, "127.0.0.1") != 0;
+    pid_t pid = -1;
+    if (!remote) {
+        pid = ::fork();
+        if (pid == 0) {
+            runClient(listenIp, port);
+            ::_exit(0);
+        }
+    }
+
+    Timestamp start(Timestamp::now());
+    double cpuStart = cpuSeconds();
+    loop.loop();
+    double elapsed = timeDifference(Timestamp::now(), start);
+    double cpu = cpuSeconds() - cpuStart;
+    if (pid > 0) {
+        ::waitpid(pid, nullptr, 0);
+    }
+
+    fprintf(stderr, "[%s %zu] sent=%lld MB time=%.3fs throughput=%.0f MiB/s server cpu=%.3fs (%.2f s/GiB)\n",
+        argv[1], msgSize, static_cast<long long>(g_sentBytes >> 20), elapsed, g_sentBytes / 1048576.0 / elapsed,
+        cpu, cpu / (g_sentBytes / 1073741824.0));
+    return 0;
+}
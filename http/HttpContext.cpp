@@ -3,6 +3,8 @@
 
 #include <algorithm>
 #include <mymuduo/Buffer.h>
+#include <mymuduo/StringSearch.h>
+#include <string_view>
 
 bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
 {
@@ -11,62 +13,248 @@ bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
 
     while (hasMore) {
         if (state_ == kExpectRequestLine) {
-            // 解析请求行
-            const char* crlf = buf->findCRLF(); // 找第一个\r\n
-            if (crlf) { // 第一个\r\n之前的数据是请求行
-                ok = processRequestLine(buf->peek(), crlf);
+            // 找请求头结尾的空行，上次没找到的部分不再重复查找，回退3字节防止\r\n\r\n被分在两次数据中
+            const char* begin = buf->peek();
+            const char* from = begin + (headerScanned_ > 3 ? headerScanned_ - 3 : 0);
+            const char* blank = StringSearch::findDoubleCRLF(from, buf->beginWrite());
+            if (blank) {
+                headerScanned_ = 0;
+                // 请求头一次全部收到时也要检查长度
+                ok = static_cast<size_t>(blank + 4 - begin) <= maxHeaderSize_ && processHeaders(begin, blank + 2);
                 if (ok) {
                     request_.setReceiveTime(receiveTime);
-                    buf->retrieve(crlf + 2 - buf->peek());
-
-                    // 解析请求行完成，接下来解析请求头
-                    state_ = kExpectHeaders;
-                } else {
-                    hasMore = false; // 解析出错，停止解析
+                    ok = processHeadersEnd(buf, blank + 4 - begin);
                 }
-            }else {
-                hasMore = false; // 解析出错，停止解析
+                hasMore = ok && state_ != kGotAll;
+            } else {
+                headerScanned_ = buf->readableBytes();
+                ok = headerScanned_ <= maxHeaderSize_; // 请求头太长
+                hasMore = false;
             }
-        }else if (state_ == kExpectHeaders) {
+        }else if (state_ == kExpectBody) {
+            // 有多少取多少，剩下的等下次收到数据
+            size_t n = std::min(buf->readableBytes(), bodyRemaining_);
+            request_.appendBody(buf->peek(), n);
+            buf->retrieve(n);
+            bodyRemaining_ -= n;
+            if (bodyRemaining_ == 0) {
+                state_ = kGotAll;
+            }
+            hasMore = false;
+        }else if (state_ == kExpectChunkSize) {
             const char* crlf = buf->findCRLF();
             if (crlf) {
-                // 请求头以:分隔key-value
-                const char* colon = std::find(buf->peek(), crlf, ':');
-                if (colon != crlf) {
-                    // 请求头的key-value添加到map中
-                    request_.addHeader(buf->peek(), colon, crlf);
-                }
-                else {
-                    // 没有:，空行，空行是请求头的结束标志
+                ok = processChunkSize(buf->peek(), crlf);
+                buf->retrieve(crlf + 2 - buf->peek());
+                hasMore = ok;
+            } else {
+                ok = buf->readableBytes() <= kMaxChunkSizeLine; // 长度行太长，不是合法的chunk
+                hasMore = false;
+            }
+        }else if (state_ == kExpectChunkData) {
+            size_t n = std::min(buf->readableBytes(), bodyRemaining_);
+            request_.appendBody(buf->peek(), n);
+            buf->retrieve(n);
+            bodyRemaining_ -= n;
+            if (bodyRemaining_ == 0) {
+                state_ = kExpectChunkDataCRLF;
+            } else {
+                hasMore = false;
+            }
+        }else if (state_ == kExpectChunkDataCRLF) {
+            if (buf->readableBytes() >= 2) {
+                ok = buf->peek()[0] == '\r' && buf->peek()[1] == '\n';
+                buf->retrieve(2);
+                state_ = kExpectChunkSize;
+                hasMore = ok;
+            } else {
+                hasMore = false;
+            }
+        }else if (state_ == kExpectTrailers) {
+            // trailer与请求头一样受maxHeaderSize_限制，包括还没有收到\r\n的一行
+            const char* crlf = buf->findCRLF();
+            if (crlf) {
+                // trailer没有用处，丢弃，收到空行时请求结束
+                if (crlf == buf->peek()) {
                     state_ = kGotAll;
                     hasMore = false;
                 }
+                trailerBytes_ += crlf + 2 - buf->peek();
                 buf->retrieve(crlf + 2 - buf->peek());
-            }else {
+                ok = trailerBytes_ <= maxHeaderSize_;
+                hasMore = hasMore && ok;
+            } else {
+                ok = trailerBytes_ + buf->readableBytes() <= maxHeaderSize_;
                 hasMore = false;
             }
-        }else if (state_ == kExpectBody) {
-            
+        }else {
+            hasMore = false; // kGotAll，等待finishRequest
         }
     }
     return ok;
 }
 
+bool HttpContext::processHeaders(const char* begin, const char* end)
+{
+    // 第一个\r\n之前的数据是请求行
+    const char* crlf = StringSearch::findCRLF(begin, end);
+    if (!processRequestLine(begin, crlf)) {
+        return false;
+    }
+
+    // 请求头以:分隔key-value
+    for (const char* line = crlf + 2; line < end; line = crlf + 2) {
+        crlf = StringSearch::findCRLF(line, end);
+        const char* colon = StringSearch::findByte(line, crlf, ':');
+        if (!colon || !request_.addHeader(line, colon, crlf)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Transfer-Encoding的取值中是否有chunked，不区分大小写
+static bool isChunked(std::string_view encoding)
+{
+    const std::string_view chunked("chunked");
+    for (size_t i = 0; i + chunked.size() <= encoding.size(); ++i) {
+        if (equalsIgnoreCase(encoding.substr(i, chunked.size()), chunked)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HttpContext::processHeadersEnd(Buffer* buf, size_t headerBytes)
+{
+    // 同时有Transfer-Encoding和Content-Length时以chunked为准
+    if (isChunked(request_.getHeader("Transfer-Encoding"))) {
+        ownHeaders(buf, headerBytes);
+        state_ = kExpectChunkSize;
+        return true;
+    }
+
+    std::string_view length = request_.getHeader("Content-Length");
+    if (length.data() == nullptr) {
+        deferredRetrieve_ = headerBytes; // 没有请求体
+        state_ = kGotAll;
+        return true;
+    }
+
+    if (length.empty() || length.size() > 19) {
+        return false;
+    }
+    size_t contentLength = 0;
+    for (char c : length) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        contentLength = contentLength * 10 + (c - '0');
+    }
+    if (!checkBodySize(contentLength)) {
+        return false;
+    }
+
+    if (buf->readableBytes() - headerBytes >= contentLength) {
+        // 请求体已经全部收到
+        const char* body = buf->peek() + headerBytes;
+        if (bodyView_) {
+            request_.setBodyView(body, contentLength);
+        } else {
+            request_.appendBody(body, contentLength);
+        }
+        deferredRetrieve_ = headerBytes + contentLength;
+        state_ = kGotAll;
+    } else {
+        ownHeaders(buf, headerBytes);
+        request_.reserveBody(contentLength);
+        bodyRemaining_ = contentLength;
+        state_ = kExpectBody;
+    }
+    return true;
+}
+
+void HttpContext::ownHeaders(Buffer* buf, size_t headerBytes)
+{
+    request_.ownHeaders(buf->peek(), headerBytes);
+    buf->retrieve(headerBytes);
+}
+
+// chunk长度行格式---1a3f;name=value 十六进制长度，后面可能有扩展
+bool HttpContext::processChunkSize(const char* begin, const char* end)
+{
+    size_t size = 0;
+    const char* p = begin;
+    for (; p < end; ++p) {
+        int digit;
+        if (*p >= '0' && *p <= '9') {
+            digit = *p - '0';
+        } else if (*p >= 'a' && *p <= 'f') {
+            digit = *p - 'a' + 10;
+        } else if (*p >= 'A' && *p <= 'F') {
+            digit = *p - 'A' + 10;
+        } else {
+            break;
+        }
+        if (size > (maxBodySize_ >> 4)) {
+            bodyTooLarge_ = true; // 再乘16就超过上限，也避免溢出
+            return false;
+        }
+        size = (size << 4) | digit;
+    }
+    if (p == begin || (p != end && *p != ';' && *p != ' ' && *p != '\t')) {
+        return false;
+    }
+
+    if (size == 0) {
+        state_ = kExpectTrailers; // 最后一个chunk
+        return true;
+    }
+    if (!checkBodySize(request_.body().size() + size)) {
+        return false;
+    }
+    bodyRemaining_ = size;
+    state_ = kExpectChunkData;
+    return true;
+}
+
+bool HttpContext::checkBodySize(size_t len)
+{
+    if (len > maxBodySize_) {
+        bodyTooLarge_ = true;
+        return false;
+    }
+    return true;
+}
+
+void HttpContext::finishRequest(Buffer* buf)
+{
+    buf->retrieve(deferredRetrieve_);
+    reset();
+}
+
+// 找不到时返回end，与std::find一致
+static const char* findSpace(const char* begin, const char* end)
+{
+    const char* space = StringSearch::findByte(begin, end, ' ');
+    return space ? space : end;
+}
+
 bool HttpContext::processRequestLine(const char* begin, const char* end)
 {
     bool succeed = false;
     const char* start = begin;
-    const char* space = std::find(start, end, ' ');
+    const char* space = findSpace(start, end);
 
     // 请求行格式---GET /hello.txt HTTP/1.1
     // 请求方法 URL 协议版本\r\n 中间以空格分隔
     if (space != end && request_.setMethod(start, space)) {
         // 成功获取请求方法，继续查找URL
         start = space + 1;
-        space = std::find(start, end, ' ');
+        space = findSpace(start, end);
         if (space != end) {
-            const char* question = std::find(start, space, '?');
-            if (question != space) {
+            const char* question = StringSearch::findByte(start, space, '?');
+            if (question) {
                 request_.setPath(start, question); // ？前是路径
                 request_.setQuery(question, space);
             } else {
@@ -4,33 +4,69 @@
 #pragma once
 #include "HttpRequest.h"
 
+#include <cstddef>
+
 class Buffer;
 class Timestamp;
 
 // HTTP请求解析器，对于不同内容的解析方法不同
+// 请求行和请求头全部收到后才一次解析，解析出的字段直接引用输入Buffer，请求处理完后由finishRequest从Buffer中取走
+// 请求体支持Content-Length和Transfer-Encoding: chunked两种方式，数据不完整时保存进度，下次收到数据后继续解析
 class HttpContext {
 public:
     enum HttpRequestParseState {
-        kExpectRequestLine,
-        kExpectHeaders,
-        kExpectBody,
+        kExpectRequestLine, // 等待请求行和请求头全部收到
+        kExpectBody, // Content-Length指定长度的请求体
+        kExpectChunkSize, // chunk的长度行
+        kExpectChunkData,
+        kExpectChunkDataCRLF, // chunk数据后的\r\n
+        kExpectTrailers, // 最后一个长度为0的chunk之后的trailer，以空行结束
         kGotAll,
     };
 
+    static const size_t kDefaultMaxBodySize = 1024 * 1024;
+    static const size_t kDefaultMaxHeaderSize = 64 * 1024;
+    static const size_t kMaxChunkSizeLine = 1024; // chunk长度行(包括扩展)的最大长度
+
     HttpContext()
         : state_(kExpectRequestLine)
+        , maxBodySize_(kDefaultMaxBodySize)
+        , maxHeaderSize_(kDefaultMaxHeaderSize)
+        , bodyView_(false)
+        , bodyTooLarge_(false)
+        , bodyRemaining_(0)
+        , deferredRetrieve_(0)
+        , headerScanned_(0)
+        , trailerBytes_(0)
     {
     }
 
+    // 解析出错返回false，请求体超过上限时bodyTooLarge()为true
     bool parseRequest(Buffer* buf, Timestamp receiveTime);
 
     bool gotAll() const { return state_ == kGotAll; }
+    bool bodyTooLarge() const { return bodyTooLarge_; }
+
+    // 请求体(解码后)的最大字节数，超过时解析失败
+    void setMaxBodySize(size_t size) { maxBodySize_ = size; }
+    // Content-Length的请求体在请求头解析完时已经全部收到的话，HttpRequest::body直接引用输入Buffer，
+    // 这部分数据在finishRequest时才从Buffer中取走
+    void setBodyView(bool on) { bodyView_ = on; }
+    // 请求行和请求头的最大字节数，trailer也受这个限制，超过时解析失败
+    void setMaxHeaderSize(size_t size) { maxHeaderSize_ = size; }
+
+    // 请求处理完后调用，从Buffer中取走这个请求并准备解析下一个请求
+    void finishRequest(Buffer* buf);
 
     void reset()
     {
         state_ = kExpectRequestLine;
-        HttpRequest dummy;
-        request_.swap(dummy);
+        bodyTooLarge_ = false;
+        bodyRemaining_ = 0;
+        deferredRetrieve_ = 0;
+        headerScanned_ = 0;
+        trailerBytes_ = 0;
+        request_.clear();
     }
 
     HttpRequest& request() { return request_; }
@@ -38,9 +74,26 @@ public:
 
 private:
     bool processRequestLine(const char* begin, const char* end);
+    // 解析[begin, end)中的请求行和请求头，end是最后一个请求头的\r\n之后
+    bool processHeaders(const char* begin, const char* end);
+    // 请求头结束，根据Transfer-Encoding和Content-Length决定如何读取请求体，headerBytes包括结尾的空行
+    bool processHeadersEnd(Buffer* buf, size_t headerBytes);
+    // 请求体要分多次接收，先把请求头拷贝到HttpRequest中，再从Buffer中取走
+    void ownHeaders(Buffer* buf, size_t headerBytes);
+    bool processChunkSize(const char* begin, const char* end);
+    // 请求体增加len字节后是否超过上限
+    bool checkBodySize(size_t len);
 
     HttpRequestParseState state_;
     HttpRequest request_;
+    size_t maxBodySize_;
+    size_t maxHeaderSize_;
+    bool bodyView_;
+    bool bodyTooLarge_;
+    size_t bodyRemaining_; // 当前Content-Length请求体或chunk还没有收到的字节数
+    size_t deferredRetrieve_; // 处理完请求再从Buffer中取走的字节数
+    size_t headerScanned_; // 已经查找过空行的字节数，下次收到数据后从这里继续找
+    size_t trailerBytes_; // 已经收到并丢弃的trailer字节数
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -4,11 +4,22 @@
 #include <mymuduo/Timestamp.h>
 
 #include <cctype>
+#include <cstddef>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <strings.h>
 #pragma once
 
+// 不区分大小写比较，请求头的key和Connection等请求头的取值都不区分大小写
+inline bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && ::strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
 // HttpRequest用于解析HTTP请求
+// 路径、查询参数和请求头都是指向连接输入Buffer的string_view，请求头保存在定长数组中，解析普通的GET请求不分配内存
+// 这些string_view只在处理请求的回调期间有效，HttpContext在回调返回后才从Buffer中取走这个请求，
+// 请求体没有随请求头一起收齐时，HttpContext先用ownHeaders把请求头拷贝到HttpRequest自己的内存中
 class HttpRequest {
 public:
     enum Method { // HTTP请求方法
@@ -26,9 +37,37 @@ public:
         kHttp11
     };
 
+    // 一个请求头，field和value都已经去掉了前后的空白
+    struct Header {
+        std::string_view field;
+        std::string_view value;
+    };
+
+    // 用于遍历请求头 for (const HttpRequest::Header& header : req.headers())
+    class HeaderRange {
+    public:
+        HeaderRange(const Header* begin, const Header* end)
+            : begin_(begin)
+            , end_(end)
+        {
+        }
+        const Header* begin() const { return begin_; }
+        const Header* end() const { return end_; }
+        size_t size() const { return end_ - begin_; }
+
+    private:
+        const Header* begin_;
+        const Header* end_;
+    };
+
+    static const size_t kMaxHeaders = 64; // 超过时请求解析失败
+
     HttpRequest()
         : method_(kInvalid)
         , version_(kUnknown)
+        , numHeaders_(0)
+        , bodyView_(nullptr)
+        , bodyViewLength_(0)
     {
     }
 
@@ -37,7 +76,7 @@ public:
 
     bool setMethod(const char* start, const char* end)
     {
-        std::string m(start, end);
+        std::string_view m(start, end - start);
         if (m == "GET") {
             method_ = kGet;
         } else if (m == "POST") {
@@ -56,10 +95,12 @@ public:
     }
     Method method() const { return method_; }
 
-    const char* methodString() const
+    const char* methodString() const { return methodName(method_); }
+
+    static const char* methodName(Method method)
     {
         const char* result = "UNKNOWN";
-        switch (method_) {
+        switch (method) {
         case kGet:
             result = "GET";
             break;
@@ -81,65 +122,110 @@ public:
         return result;
     }
 
-    void setPath(const char* start, const char* end) { path_.assign(start, end); }
-    const std::string& path() const { return path_; }
+    void setPath(const char* start, const char* end) { path_ = std::string_view(start, end - start); }
+    std::string_view path() const { return path_; }
 
-    void setQuery(const char* start, const char* end) { query_.assign(start, end); }
-    const std::string& query() const { return query_; }
+    void setQuery(const char* start, const char* end) { query_ = std::string_view(start, end - start); }
+    std::string_view query() const { return query_; }
 
     void setReceiveTime(Timestamp t) { receiveTime_ = t; }
     Timestamp receiveTime() const { return receiveTime_; }
 
-    // 向map中添加一个请求行内容
-    void addHeader(const char* start, const char* colon, const char* end)
+    // 添加一个请求头，去掉value前后的空白，请求头超过kMaxHeaders个时返回false
+    bool addHeader(const char* start, const char* colon, const char* end)
     {
-        std::string field(start, colon); // colon冒号，冒号之前的是key
-        ++colon;
+        if (numHeaders_ == kMaxHeaders) {
+            return false;
+        }
 
-        while (colon < end && std::isspace(*colon)) {
-            ++colon; // 跳过冒号后面的空格
+        const char* value = colon + 1; // colon冒号，冒号之前的是key
+        while (value < end && std::isspace(*value)) {
+            ++value; // 跳过冒号后面的空格
+        }
+        const char* valueEnd = end;
+        while (valueEnd > value && std::isspace(*(valueEnd - 1))) {
+            --valueEnd; // 去除字符后的空格
         }
 
-        std::string value(colon, end);
-        while (!value.empty() && std::isspace(value[value.size() - 1])) {
-            value.resize(value.size() - 1); // 去除字符后的空格
+        Header& header = headers_[numHeaders_++];
+        header.field = std::string_view(start, colon - start);
+        header.value = std::string_view(value, valueEnd - value);
+        return true;
+    }
+
+    // 获取某个请求头的值，key不区分大小写，没有这个请求头时返回的string_view的data()为空
+    std::string_view getHeader(std::string_view field) const
+    {
+        for (size_t i = 0; i < numHeaders_; ++i) {
+            if (equalsIgnoreCase(headers_[i].field, field)) {
+                return headers_[i].value;
+            }
         }
-        headers_[field] = value; // key-value 添加到map中
+        return std::string_view();
     }
 
-    // 从map中获取某个请求字段的内容
-    std::string getHeader(const std::string& field) const
+    HeaderRange headers() const { return HeaderRange(headers_, headers_ + numHeaders_); }
+
+    // 把引用的请求行和请求头拷贝到自己的内存中，之后输入Buffer中的这部分数据可以取走
+    // [data, data + len)必须包含所有引用的数据
+    void ownHeaders(const char* data, size_t len)
     {
-        std::string result;
-        std::unordered_map<std::string, std::string>::const_iterator it = headers_.find(field);
-        if (it != headers_.end()) {
-            result = it->second;
+        storage_.assign(data, len);
+        const char* base = storage_.data();
+        auto rebase = [data, base](std::string_view& view) {
+            if (view.data() != nullptr) {
+                view = std::string_view(base + (view.data() - data), view.size());
+            }
+        };
+        rebase(path_);
+        rebase(query_);
+        for (size_t i = 0; i < numHeaders_; ++i) {
+            rebase(headers_[i].field);
+            rebase(headers_[i].value);
         }
-        return result;
     }
 
-    const std::unordered_map<std::string, std::string>& headers() const
+    // 请求体，解析器逐段追加解码后的数据
+    void appendBody(const char* data, size_t len) { body_.append(data, len); }
+    void reserveBody(size_t len) { body_.reserve(len); }
+    // 请求体已经完整地在输入Buffer中时直接引用Buffer中的数据，不拷贝，只在处理请求的回调期间有效
+    void setBodyView(const char* data, size_t len)
+    {
+        bodyView_ = data;
+        bodyViewLength_ = len;
+    }
+    std::string_view body() const
     {
-        return headers_;
+        return bodyView_ ? std::string_view(bodyView_, bodyViewLength_) : std::string_view(body_);
     }
 
-    void swap(HttpRequest& that)
+    // 清空所有字段，保留已经分配的内存，准备解析下一个请求
+    void clear()
     {
-        std::swap(method_, that.method_);
-        std::swap(version_, that.version_);
-        path_.swap(that.path_);
-        query_.swap(that.path_);
-        headers_.swap(that.headers_);
-        receiveTime_.swap(that.receiveTime_);
+        method_ = kInvalid;
+        version_ = kUnknown;
+        path_ = std::string_view();
+        query_ = std::string_view();
+        receiveTime_ = Timestamp();
+        numHeaders_ = 0;
+        storage_.clear();
+        body_.clear();
+        bodyView_ = nullptr;
+        bodyViewLength_ = 0;
     }
 
 private:
     Method method_; // HTTP请求方法
     Version version_; // HTTP协议版本
-    std::string path_;
-    std::string query_;
+    std::string_view path_;
+    std::string_view query_;
     Timestamp receiveTime_;
-    std::unordered_map<std::string, std::string> headers_; // 请求头通过:冒号分隔key-value，使用map保存
+    Header headers_[kMaxHeaders]; // 请求头通过:冒号分隔key-value，按收到的顺序保存
+    size_t numHeaders_;
+    std::string storage_; // ownHeaders拷贝的请求行和请求头
+    std::string body_; // 拷贝出来的请求体，chunked编码时是解码后的数据
+    const char* bodyView_; // 不为空时请求体是输入Buffer中的这一段
+    size_t bodyViewLength_;
 };
 
 #endif
\ No newline at end of file
@@ -5,7 +5,7 @@
 #include <string>
 
 // 构造响应报文
-void HttpResponse::appendToBuffer(Buffer* output) const
+void HttpResponse::appendToBuffer(Buffer* output, bool withBody) const
 {
     char buf[32];
     snprintf(buf, sizeof buf, "HTTP/1.1 %d ", statusCode_);
@@ -16,8 +16,10 @@ void HttpResponse::appendToBuffer(Buffer* output) const
     if (closeConnection_) {
         output->append("Connection: close\r\n");
     } else {
-        snprintf(buf, sizeof buf, "Content-Length: %zd\r\n", body_.size());
-        output->append(buf);
+        if (statusCode_ != k304NotModified) { // 304没有响应体，不声明长度
+            snprintf(buf, sizeof buf, "Content-Length: %zd\r\n", hasFile() ? fileLength_ : body_.size());
+            output->append(buf);
+        }
         output->append("Connection: Keep-Alive\r\n");
     }
 
@@ -29,5 +31,7 @@ void HttpResponse::appendToBuffer(Buffer* output) const
     }
 
     output->append("\r\n");
-    output->append(body_);
+    if (withBody && !hasFile()) {
+        output->append(body_);
+    }
 }
@@ -1,7 +1,9 @@
 #ifndef HTTPRESPONSE_H
 #define HTTPRESPONSE_H
 
+#include <memory>
 #include <string>
+#include <sys/types.h>
 #include <unordered_map>
 #pragma once
 
@@ -13,14 +15,22 @@ public:
     enum HttpStatusCode { // 响应状态
         kUnknown,
         k200Ok = 200,
+        k206PartialContent = 206,
         k301MovedPermanently = 301,
+        k304NotModified = 304,
         k400BadRequest = 400,
         k404NotFound = 404,
+        k405MethodNotAllowed = 405,
+        k413PayloadTooLarge = 413,
+        k416RangeNotSatisfiable = 416,
     };
 
     explicit HttpResponse(bool close)
         : statusCode_(kUnknown)
         , closeConnection_(close)
+        , fileFd_(-1)
+        , fileOffset_(0)
+        , fileLength_(0)
     {
     }
 
@@ -40,8 +50,23 @@ public:
 
     void setBody(const std::string& body) { body_ = body; }
 
-    // 构造响应报文
-    void appendToBuffer(Buffer* output) const;
+    // 响应体是文件fd中[offset, offset + length)的区域，HttpServer先发送报文头，再用TcpConnection::sendFile发送文件，
+    // 不读进body_，owner在发送完成之前一直被持有，保证fd不被关闭
+    void setFile(std::shared_ptr<const void> owner, int fd, off_t offset, size_t length)
+    {
+        fileOwner_ = std::move(owner);
+        fileFd_ = fd;
+        fileOffset_ = offset;
+        fileLength_ = length;
+    }
+    bool hasFile() const { return fileFd_ >= 0; }
+    const std::shared_ptr<const void>& fileOwner() const { return fileOwner_; }
+    int fileFd() const { return fileFd_; }
+    off_t fileOffset() const { return fileOffset_; }
+    size_t fileLength() const { return fileLength_; }
+
+    // 构造响应报文，有文件时只包括报文头，withBody为false时(HEAD请求)不附加响应体，Content-Length不变
+    void appendToBuffer(Buffer* output, bool withBody = true) const;
 
 private:
     std::unordered_map<std::string, std::string> headers_; // 消息报头map
@@ -49,6 +74,10 @@ private:
     std::string statusMessage_; // 响应状态
     std::string body_; // 响应体
     bool closeConnection_;
+    std::shared_ptr<const void> fileOwner_;
+    int fileFd_;
+    off_t fileOffset_;
+    size_t fileLength_;
 };
 
 #endif
\ No newline at end of file
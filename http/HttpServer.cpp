@@ -5,8 +5,12 @@
 
 #include <any>
 #include <functional>
+#include <memory>
+#include <mymuduo/BufferPool.h>
+#include <mymuduo/EventLoop.h>
 #include <mymuduo/TcpServer.h>
 #include <string>
+#include <string_view>
 
 void defaultHttpCallback(const HttpRequest&, HttpResponse* resp)
 {
@@ -21,6 +25,8 @@ HttpServer::HttpServer(EventLoop* loop,
     TcpServer::Option option)
     : server_(loop, listenAddr, name, option)
     , httpCallback_(defaultHttpCallback)
+    , maxBodySize_(HttpContext::kDefaultMaxBodySize)
+    , bodyView_(false)
 {
     server_.setConnectionCallback(
         std::bind(&HttpServer::onConnection, this, std::placeholders::_1));
@@ -40,40 +46,86 @@ void HttpServer::start()
 void HttpServer::onConnection(const TcpConnectionPtr& conn)
 {
     if (conn->connected()) {
+        // 响应都是整个构造好再发送的，Nagle只会增加延迟，文件响应的报文头和sendFile分开发送时还会等对端的延迟ACK
+        conn->setTcpNoDelay(true);
         // 保存上下文信息，即HttpContext对象
-        conn->setContext(HttpContext());
+        HttpContext context;
+        context.setMaxBodySize(maxBodySize_);
+        context.setBodyView(bodyView_);
+        conn->setContext(context);
     }
 }
 
+// 一次收到的数据中可能有多个流水线请求，逐个处理，所有响应追加到同一个Buffer中一起发送
 void HttpServer::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime)
 {
+    // 已经决定关闭连接(kDisconnecting)，之后收到的请求既不处理也不回复
+    if (!conn->connected()) {
+        buf->retrieveAll();
+        return;
+    }
     HttpContext* context = std::any_cast<HttpContext>(conn->getMutableContext());
 
-    if (!context->parseRequest(buf, receiveTime)) {
-        conn->send("HTTP/1.1 400 Bad Request\r\n\r\n");
-        conn->shutdown();
+    // 响应Buffer的内存从loop的BufferPool借，发送完归还，每批请求不需要分配内存
+    BufferPool* pool = conn->getLoop()->bufferPool();
+    Buffer output(0);
+    output.adoptStorage(pool->acquire(Buffer::kInitialSize));
+    bool close = false;
+    while (!close) {
+        if (!context->parseRequest(buf, receiveTime)) {
+            if (context->bodyTooLarge()) {
+                output.append("HTTP/1.1 413 Payload Too Large\r\nConnection: close\r\n\r\n");
+            } else {
+                output.append("HTTP/1.1 400 Bad Request\r\n\r\n");
+            }
+            buf->retrieveAll(); // 剩下的数据已经无法解析，不再接收
+            close = true;
+            break;
+        }
+        if (!context->gotAll()) {
+            break; // 剩下的请求还不完整，等下次收到数据
+        }
+
+        close = onRequest(conn, context->request(), &output);
+        context->finishRequest(buf);
+
+        // 响应很大时先发出去，不让一批响应占用太多内存
+        if (output.readableBytes() >= kMaxBatchBytes) {
+            conn->send(&output);
+        }
     }
 
-    if (context->gotAll()) {
-        onRequest(conn, context->request());
-        context->reset();
+    if (output.readableBytes() > 0) {
+        conn->send(&output);
+    }
+    pool->release(output.releaseStorage());
+    if (close) {
+        buf->retrieveAll(); // Connection: close之后流水线中剩下的请求不再处理
+        conn->shutdown();
     }
 }
 
-void HttpServer::onRequest(const TcpConnectionPtr& conn, const HttpRequest& req)
+// 构建的响应报文追加到output，返回是否需要关闭连接
+// 响应体是文件时先发出output中已有的响应，再用sendFile排在后面发送文件，保持流水线响应的顺序
+bool HttpServer::onRequest(const TcpConnectionPtr& conn, const HttpRequest& req, Buffer* output)
 {
-    const std::string& connection = req.getHeader("Connection");
+    std::string_view connection = req.getHeader("Connection");
     // HTTP1.0使用短连接，HTTP1.1使用长连接
-    bool close = connection == "close" || (req.getVersion() == HttpRequest::kHttp10 && connection != "Keep-Alive");
+    bool close = equalsIgnoreCase(connection, "close")
+        || (req.getVersion() == HttpRequest::kHttp10 && !equalsIgnoreCase(connection, "Keep-Alive"));
 
     HttpResponse response(close);
     httpCallback_(req, &response);
 
-    Buffer buf;
-    // 构建的响应报文传入buf并使用conn发送
-    response.appendToBuffer(&buf);
-    conn->send(&buf);
-    if (response.closeConnection()) {
-        conn->shutdown();
+    // HEAD请求可能由GET的handler处理，只发送报文头
+    bool withBody = req.method() != HttpRequest::kHead;
+    response.appendToBuffer(output, withBody);
+    if (withBody && response.hasFile() && response.fileLength() > 0) {
+        conn->send(output);
+        // 回调持有owner，文件发送完或者连接断开之前fd不会被关闭
+        std::shared_ptr<const void> owner = response.fileOwner();
+        conn->sendFile(response.fileFd(), response.fileOffset(), response.fileLength(),
+            [owner](const TcpConnectionPtr&, bool) {});
     }
+    return response.closeConnection();
 }
@@ -1,6 +1,7 @@
 #ifndef HTTPSERVER_H
 #define HTTPSERVER_H
 
+#include <cstddef>
 #include <functional>
 #include <mymuduo/TcpServer.h>
 #include <string>
@@ -32,15 +33,24 @@ public:
         server_.setThreadNum(numThreads);
     }
 
+    // 每个请求体的最大字节数，超过时回复413并关闭连接，在start之前设置
+    void setMaxBodySize(size_t size) { maxBodySize_ = size; }
+    // 请求体已经完整收到时HttpRequest::body直接引用连接的输入Buffer，不拷贝，在start之前设置
+    void setBodyView(bool on) { bodyView_ = on; }
+
     void start();
 
 private:
     void onConnection(const TcpConnectionPtr& conn);
     void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
-    void onRequest(const TcpConnectionPtr&, const HttpRequest&);
+    bool onRequest(const TcpConnectionPtr& conn, const HttpRequest& req, Buffer* output);
+
+    static const size_t kMaxBatchBytes = 64 * 1024; // 一批响应超过这个大小就先发送
 
     TcpServer server_;
     HttpCallback httpCallback_;
+    size_t maxBodySize_;
+    bool bodyView_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "Router.h"
+#include "HttpResponse.h"
+
+#include <mymuduo/Logger.h>
+
+Router::Router()
+    : root_(new Node)
+{
+}
+
+Router::~Router() = default;
+
+bool Router::addRoute(HttpRequest::Method method, const std::string& pattern, Handler handler)
+{
+    if (method == HttpRequest::kInvalid || pattern.empty() || pattern[0] != '/') {
+        LOG_ERROR("Router::addRoute invalid route %s\n", pattern.c_str());
+        return false;
+    }
+
+    // :参数和*通配只能在一段的开头，参数名不能为空，*通配只能是最后一段
+    bool hasParam = false;
+    for (size_t i = 1; i < pattern.size(); ++i) {
+        if (pattern[i] != ':' && pattern[i] != '*') {
+            continue;
+        }
+        size_t end = pattern[i] == ':' ? pattern.find('/', i) : pattern.size();
+        if (end == std::string::npos) {
+            end = pattern.size();
+        }
+        std::string_view name(pattern.data() + i + 1, end - i - 1);
+        if (pattern[i - 1] != '/' || name.empty() || name.find_first_of(":*/") != std::string_view::npos) {
+            LOG_ERROR("Router::addRoute invalid route %s\n", pattern.c_str());
+            return false;
+        }
+        hasParam = true;
+        i = end;
+    }
+
+    Node* node = insert(root_.get(), pattern);
+    if (node == nullptr) {
+        LOG_ERROR("Router::addRoute route %s conflicts with an existing route\n", pattern.c_str());
+        return false;
+    }
+    if (node->handlers[method]) {
+        LOG_ERROR("Router::addRoute duplicate route %s %s\n", HttpRequest::methodName(method), pattern.c_str());
+        return false;
+    }
+
+    node->handlers[method] = std::move(handler);
+    if (!node->hasHandler) {
+        node->hasHandler = true;
+        node->pattern = pattern;
+        if (!hasParam) {
+            staticRoutes_[node->pattern] = node;
+        }
+    }
+    return true;
+}
+
+Router::Node* Router::insert(Node* node, std::string_view rest)
+{
+    while (!rest.empty()) {
+        if (rest[0] == ':' || rest[0] == '*') {
+            size_t end = rest[0] == ':' ? rest.find('/') : rest.size();
+            if (end == std::string_view::npos) {
+                end = rest.size();
+            }
+            std::string_view name = rest.substr(1, end - 1);
+            std::unique_ptr<Node>& child = rest[0] == ':' ? node->paramChild : node->wildcardChild;
+            if (!child) {
+                child.reset(new Node);
+                child->paramName.assign(name.data(), name.size());
+            } else if (child->paramName != name) {
+                return nullptr; // 同一个位置的参数名不同，无法区分
+            }
+            node = child.get();
+            rest.remove_prefix(end);
+        } else {
+            std::string_view literal = rest.substr(0, rest.find_first_of(":*"));
+            node = insertStatic(node, literal);
+            rest.remove_prefix(literal.size());
+        }
+    }
+    return node;
+}
+
+Router::Node* Router::insertStatic(Node* node, std::string_view literal)
+{
+    while (!literal.empty()) {
+        size_t index = node->indices.find(literal[0]);
+        if (index == std::string::npos) {
+            std::unique_ptr<Node> child(new Node);
+            child->prefix.assign(literal.data(), literal.size());
+            node->children.push_back(std::move(child));
+            node->indices.push_back(literal[0]);
+            return node->children.back().get();
+        }
+        std::unique_ptr<Node>* slot = &node->children[index];
+
+        // 与已有的边的公共前缀
+        const std::string& prefix = (*slot)->prefix;
+        size_t common = 0;
+        while (common < prefix.size() && common < literal.size() && prefix[common] == literal[common]) {
+            ++common;
+        }
+
+        if (common < prefix.size()) {
+            // 边只匹配了一部分，在公共前缀处拆成两个节点
+            std::unique_ptr<Node> middle(new Node);
+            middle->prefix = prefix.substr(0, common);
+            (*slot)->prefix.erase(0, common);
+            middle->indices.push_back((*slot)->prefix[0]);
+            middle->children.push_back(std::move(*slot));
+            *slot = std::move(middle);
+        }
+        node = slot->get();
+        literal.remove_prefix(common);
+    }
+    return node;
+}
+
+const Router::Handler* Router::handlerFor(const Node* node, HttpRequest::Method method)
+{
+    if (node->handlers[method]) {
+        return &node->handlers[method];
+    }
+    if (method == HttpRequest::kHead && node->handlers[HttpRequest::kGet]) {
+        return &node->handlers[HttpRequest::kGet]; // HEAD与GET的响应相同，只是不发送响应体
+    }
+    return nullptr;
+}
+
+const Router::Node* Router::matchNode(const Node* node, std::string_view path, HttpRequest::Method method,
+    RouteParams* params, bool* pathMatched)
+{
+    if (path.empty()) {
+        if (node->hasHandler) {
+            if (handlerFor(node, method)) {
+                return node;
+            }
+            *pathMatched = true; // 还要继续尝试通配段
+        }
+    } else {
+        // 静态边优先，首字符各不相同，最多只有一条边可能匹配
+        size_t index = node->indices.find(path[0]);
+        if (index != std::string::npos) {
+            const Node* child = node->children[index].get();
+            if (path.compare(0, child->prefix.size(), child->prefix) == 0) {
+                const Node* found = matchNode(child, path.substr(child->prefix.size()), method, params, pathMatched);
+                if (found) {
+                    return found;
+                }
+            }
+        }
+
+        // 参数匹配到下一个/为止，不能为空
+        if (node->paramChild) {
+            size_t end = path.find('/');
+            if (end == std::string_view::npos) {
+                end = path.size();
+            }
+            if (end > 0 && params->push(node->paramChild->paramName, path.substr(0, end))) {
+                const Node* found = matchNode(node->paramChild.get(), path.substr(end), method, params, pathMatched);
+                if (found) {
+                    return found;
+                }
+                params->pop(); // 回溯
+            }
+        }
+    }
+
+    // 通配匹配剩下的全部路径，可以为空
+    const Node* wildcard = node->wildcardChild.get();
+    if (wildcard && wildcard->hasHandler) {
+        if (!handlerFor(wildcard, method)) {
+            *pathMatched = true;
+        } else if (params->push(wildcard->paramName, path)) {
+            return wildcard;
+        }
+    }
+    return nullptr;
+}
+
+const Router::Handler* Router::match(HttpRequest::Method method, std::string_view path,
+    RouteParams* params, bool* methodNotAllowed) const
+{
+    if (methodNotAllowed) {
+        *methodNotAllowed = false;
+    }
+
+    // 没有参数的路由直接命中，这个路径没有注册请求方法时还可能匹配参数路由，要走基数树
+    auto it = staticRoutes_.find(path);
+    if (it != staticRoutes_.end()) {
+        const Handler* handler = handlerFor(it->second, method);
+        if (handler) {
+            return handler;
+        }
+    }
+
+    bool pathMatched = false;
+    const Node* node = matchNode(root_.get(), path, method, params, &pathMatched);
+    if (node == nullptr) {
+        if (methodNotAllowed) {
+            *methodNotAllowed = pathMatched;
+        }
+        return nullptr;
+    }
+    return handlerFor(node, method);
+}
+
+bool Router::dispatch(const HttpRequest& req, HttpResponse* resp) const
+{
+    RouteParams params;
+    bool methodNotAllowed = false;
+    const Handler* handler = match(req.method(), req.path(), &params, &methodNotAllowed);
+    if (handler) {
+        (*handler)(req, params, resp);
+        return true;
+    }
+
+    if (methodNotAllowed) {
+        resp->setStatusCode(HttpResponse::k405MethodNotAllowed);
+        resp->setStatusMessage("Method Not Allowed");
+    } else {
+        resp->setStatusCode(HttpResponse::k404NotFound);
+        resp->setStatusMessage("Not Found");
+    }
+    return false;
+}
@@ -0,0 +1,125 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#pragma once
+#include "HttpRequest.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class HttpResponse;
+
+// 路由匹配出的路径参数，值是指向请求路径的string_view，只在处理请求的回调期间有效
+class RouteParams {
+public:
+    static const size_t kMaxParams = 8;
+
+    RouteParams()
+        : size_(0)
+    {
+    }
+
+    // 没有这个参数时返回的string_view的data()为空
+    std::string_view get(std::string_view name) const
+    {
+        for (size_t i = 0; i < size_; ++i) {
+            if (names_[i] == name) {
+                return values_[i];
+            }
+        }
+        return std::string_view();
+    }
+
+    size_t size() const { return size_; }
+    std::string_view name(size_t i) const { return names_[i]; }
+    std::string_view value(size_t i) const { return values_[i]; }
+
+    bool push(std::string_view name, std::string_view value)
+    {
+        if (size_ == kMaxParams) {
+            return false;
+        }
+        names_[size_] = name;
+        values_[size_] = value;
+        ++size_;
+        return true;
+    }
+    void pop() { --size_; }
+
+private:
+    std::string_view names_[kMaxParams];
+    std::string_view values_[kMaxParams];
+    size_t size_;
+};
+
+//
+// 按请求方法和路径分发请求，路径模式中的一段可以是
+//   /users/new          静态路径
+//   /users/:id          :id匹配一段，不包括/
+//   /static/*filepath   *filepath匹配剩下的全部路径，只能在最后
+// 所有路由编译成一棵基数树，匹配时间只与路径长度有关，与路由个数无关，静态段优先于参数段，参数段优先于通配段，
+// 没有参数的路由另外放在哈希表中，一次查找就能命中
+// 匹配过程不分配内存，参数通过栈上的RouteParams交给handler
+// 路由在start之前注册，之后只读，可以被多个loop线程同时使用
+//
+// Router router;
+// router.addRoute(HttpRequest::kGet, "/users/:id", handler);
+// server.setHttpCallback(std::bind(&Router::dispatch, &router, _1, _2));
+//
+class Router {
+public:
+    using Handler = std::function<void(const HttpRequest&, const RouteParams&, HttpResponse*)>;
+
+    Router();
+    ~Router();
+
+    // 模式不合法或者与已有路由冲突时返回false
+    bool addRoute(HttpRequest::Method method, const std::string& pattern, Handler handler);
+    bool get(const std::string& pattern, Handler handler) { return addRoute(HttpRequest::kGet, pattern, std::move(handler)); }
+    bool post(const std::string& pattern, Handler handler) { return addRoute(HttpRequest::kPost, pattern, std::move(handler)); }
+
+    // 查找路由，找到时填写params并返回handler，没有匹配的路径时返回nullptr，
+    // 路径匹配但没有注册这个请求方法时返回nullptr并把*methodNotAllowed置为true
+    // 某个节点没有这个请求方法的handler时继续回溯尝试参数段和通配段，HEAD没有注册时使用GET的handler
+    const Handler* match(HttpRequest::Method method, std::string_view path,
+        RouteParams* params, bool* methodNotAllowed = nullptr) const;
+
+    // 分发请求，没有匹配的路由时回复404，请求方法不匹配时回复405，返回是否找到了handler
+    bool dispatch(const HttpRequest& req, HttpResponse* resp) const;
+
+private:
+    static const int kNumMethods = HttpRequest::kDelete + 1;
+
+    struct Node {
+        std::string prefix; // 静态节点的边，参数节点和通配节点为空
+        std::string paramName; // 参数节点和通配节点的参数名
+        std::vector<std::unique_ptr<Node>> children; // 静态子节点，首字符各不相同
+        std::string indices; // children各自的首字符，查找时只扫描这个连续的字符串
+        std::unique_ptr<Node> paramChild;
+        std::unique_ptr<Node> wildcardChild;
+        Handler handlers[kNumMethods];
+        std::string pattern; // 在这个节点结束的路由模式
+        bool hasHandler = false;
+    };
+
+    // 在node之后插入模式中剩下的部分rest，返回路由结束的节点，冲突时返回nullptr
+    Node* insert(Node* node, std::string_view rest);
+    Node* insertStatic(Node* node, std::string_view literal);
+    // 节点上处理method的handler，没有时返回nullptr
+    static const Handler* handlerFor(const Node* node, HttpRequest::Method method);
+    // node的前缀已经匹配，继续匹配剩下的路径，只接受有method的handler的节点，
+    // 路径匹配但方法不匹配时把*pathMatched置为true
+    static const Node* matchNode(const Node* node, std::string_view path, HttpRequest::Method method,
+        RouteParams* params, bool* pathMatched);
+
+    std::unique_ptr<Node> root_;
+    // 没有参数的路由，key指向Node::pattern
+    std::unordered_map<std::string_view, const Node*> staticRoutes_;
+};
+
+#endif
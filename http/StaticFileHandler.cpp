@@ -0,0 +1,374 @@
+#include "StaticFileHandler.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+
+#include <mymuduo/Logger.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char* contentTypeOf(std::string_view path)
+{
+    static const struct {
+        const char* extension;
+        const char* type;
+    } kTypes[] = {
+        { ".html", "text/html" },
+        { ".htm", "text/html" },
+        { ".css", "text/css" },
+        { ".js", "application/javascript" },
+        { ".json", "application/json" },
+        { ".txt", "text/plain" },
+        { ".png", "image/png" },
+        { ".jpg", "image/jpeg" },
+        { ".jpeg", "image/jpeg" },
+        { ".gif", "image/gif" },
+        { ".svg", "image/svg+xml" },
+        { ".ico", "image/x-icon" },
+        { ".wasm", "application/wasm" },
+        { ".pdf", "application/pdf" },
+        { ".mp4", "video/mp4" },
+        { ".woff2", "font/woff2" },
+    };
+
+    size_t dot = path.rfind('.');
+    if (dot != std::string_view::npos && path.find('/', dot) == std::string_view::npos) {
+        std::string_view extension = path.substr(dot);
+        for (const auto& t : kTypes) {
+            if (equalsIgnoreCase(extension, t.extension)) {
+                return t.type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+// 路径中不能有..段，不能有\0
+bool isSafePath(std::string_view path)
+{
+    if (path.find('\0') != std::string_view::npos) {
+        return false;
+    }
+    size_t begin = 0;
+    while (begin <= path.size()) {
+        size_t end = path.find('/', begin);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        if (path.substr(begin, end - begin) == "..") {
+            return false;
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+// 非空并且全是数字
+bool parseNumber(std::string_view s, uint64_t* value)
+{
+    if (s.empty() || s.size() > 19) {
+        return false;
+    }
+    uint64_t n = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        n = n * 10 + (c - '0');
+    }
+    *value = n;
+    return true;
+}
+
+bool parseHttpDate(std::string_view s, time_t* t)
+{
+    char buf[64];
+    if (s.size() >= sizeof buf) {
+        return false;
+    }
+    ::memcpy(buf, s.data(), s.size());
+    buf[s.size()] = '\0';
+
+    struct tm tm;
+    ::memset(&tm, 0, sizeof tm);
+    const char* end = ::strptime(buf, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (end == nullptr || *end != '\0') {
+        return false;
+    }
+    *t = ::timegm(&tm);
+    return true;
+}
+
+enum RangeResult {
+    kNoRange, // 没有Range或者无法识别，回复整个文件
+    kRange,
+    kUnsatisfiable,
+};
+
+// 只支持单个区间的bytes=first-last、bytes=first-和bytes=-suffix，多个区间时回复整个文件
+RangeResult parseRange(std::string_view range, uint64_t size, uint64_t* offset, uint64_t* length)
+{
+    if (range.compare(0, 6, "bytes=") != 0) {
+        return kNoRange;
+    }
+    range.remove_prefix(6);
+    size_t dash = range.find('-');
+    if (dash == std::string_view::npos || range.find(',') != std::string_view::npos) {
+        return kNoRange;
+    }
+
+    uint64_t first = 0;
+    uint64_t last = 0;
+    if (dash == 0) {
+        uint64_t suffix = 0;
+        if (!parseNumber(range.substr(1), &suffix)) {
+            return kNoRange;
+        }
+        if (suffix == 0 || size == 0) {
+            return kUnsatisfiable;
+        }
+        first = suffix < size ? size - suffix : 0;
+        last = size - 1;
+    } else {
+        if (!parseNumber(range.substr(0, dash), &first)) {
+            return kNoRange;
+        }
+        std::string_view lastStr = range.substr(dash + 1);
+        if (lastStr.empty()) {
+            last = size - 1;
+        } else if (!parseNumber(lastStr, &last) || last < first) {
+            return kNoRange;
+        }
+        if (first >= size) {
+            return kUnsatisfiable;
+        }
+        if (last >= size) {
+            last = size - 1;
+        }
+    }
+
+    *offset = first;
+    *length = last - first + 1;
+    return kRange;
+}
+
+} // namespace
+
+StaticFileHandler::File::~File()
+{
+    ::close(fd);
+}
+
+StaticFileHandler::StaticFileHandler(const std::string& root, size_t cacheSize, double ttlSeconds)
+    : root_(!root.empty() && root.back() == '/' ? root : root + "/")
+    , cacheSize_(cacheSize)
+    , ttlSeconds_(ttlSeconds)
+    , hits_(0)
+    , revalidations_(0)
+    , misses_(0)
+{
+}
+
+StaticFileHandler::~StaticFileHandler() = default;
+
+StaticFileStats StaticFileHandler::stats() const
+{
+    StaticFileStats stats;
+    stats.hits = hits_;
+    stats.revalidations = revalidations_;
+    stats.misses = misses_;
+    return stats;
+}
+
+void StaticFileHandler::operator()(const HttpRequest& req, HttpResponse* resp)
+{
+    handle(req, req.path(), resp);
+}
+
+void StaticFileHandler::handle(const HttpRequest& req, std::string_view path, HttpResponse* resp)
+{
+    if (req.method() != HttpRequest::kGet && req.method() != HttpRequest::kHead) {
+        resp->setStatusCode(HttpResponse::k405MethodNotAllowed);
+        resp->setStatusMessage("Method Not Allowed");
+        resp->addHeader("Allow", "GET, HEAD");
+        return;
+    }
+
+    while (!path.empty() && path[0] == '/') {
+        path.remove_prefix(1);
+    }
+    std::string indexPath;
+    if (path.empty() || path.back() == '/') {
+        indexPath.assign(path.data(), path.size());
+        indexPath += "index.html";
+        path = indexPath;
+    }
+
+    FilePtr file = isSafePath(path) ? getFile(path) : FilePtr();
+    if (!file) {
+        resp->setStatusCode(HttpResponse::k404NotFound);
+        resp->setStatusMessage("Not Found");
+        return;
+    }
+
+    resp->addHeader("Last-Modified", file->lastModified);
+    resp->addHeader("ETag", file->etag);
+    resp->addHeader("Accept-Ranges", "bytes");
+
+    if (notModified(req, *file)) {
+        resp->setStatusCode(HttpResponse::k304NotModified);
+        resp->setStatusMessage("Not Modified");
+        return;
+    }
+    resp->setContentType(file->contentType);
+
+    uint64_t size = file->size;
+    uint64_t offset = 0;
+    uint64_t length = size;
+    RangeResult result = kNoRange;
+    std::string_view range = req.getHeader("Range");
+    std::string_view ifRange = req.getHeader("If-Range");
+    // If-Range与当前版本不符时说明客户端已有的部分过期了，回复整个文件
+    if (!range.empty() && (ifRange.empty() || ifRange == file->etag || ifRange == file->lastModified)) {
+        result = parseRange(range, size, &offset, &length);
+    }
+
+    char buf[64];
+    if (result == kUnsatisfiable) {
+        snprintf(buf, sizeof buf, "bytes */%llu", static_cast<unsigned long long>(size));
+        resp->setStatusCode(HttpResponse::k416RangeNotSatisfiable);
+        resp->setStatusMessage("Range Not Satisfiable");
+        resp->addHeader("Content-Range", buf);
+        return;
+    }
+    if (result == kRange) {
+        snprintf(buf, sizeof buf, "bytes %llu-%llu/%llu", static_cast<unsigned long long>(offset),
+            static_cast<unsigned long long>(offset + length - 1), static_cast<unsigned long long>(size));
+        resp->setStatusCode(HttpResponse::k206PartialContent);
+        resp->setStatusMessage("Partial Content");
+        resp->addHeader("Content-Range", buf);
+    } else {
+        resp->setStatusCode(HttpResponse::k200Ok);
+        resp->setStatusMessage("OK");
+    }
+    resp->setFile(file, file->fd, static_cast<off_t>(offset), static_cast<size_t>(length));
+}
+
+bool StaticFileHandler::notModified(const HttpRequest& req, const File& file)
+{
+    // 有If-None-Match时忽略If-Modified-Since
+    std::string_view ifNoneMatch = req.getHeader("If-None-Match");
+    if (!ifNoneMatch.empty()) {
+        return ifNoneMatch == "*" || ifNoneMatch.find(file.etag) != std::string_view::npos;
+    }
+
+    std::string_view ifModifiedSince = req.getHeader("If-Modified-Since");
+    if (ifModifiedSince.empty()) {
+        return false;
+    }
+    if (ifModifiedSince == file.lastModified) {
+        return true; // 浏览器通常原样带回Last-Modified，不用解析
+    }
+    time_t since = 0;
+    return parseHttpDate(ifModifiedSince, &since) && file.mtime.tv_sec <= since;
+}
+
+StaticFileHandler::FilePtr StaticFileHandler::getFile(std::string_view path)
+{
+    Timestamp now(Timestamp::now());
+    FilePtr cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(path);
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            if (timeDifference(now, it->second->validated) < ttlSeconds_) {
+                ++hits_;
+                return it->second->file;
+            }
+            cached = it->second->file;
+        }
+    }
+
+    // 缓存过期或者没有缓存，stat和open都不持有锁
+    std::string fullPath = root_;
+    fullPath.append(path.data(), path.size());
+    FilePtr file;
+    struct stat st;
+    if (::stat(fullPath.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+        if (cached && cached->ino == st.st_ino && cached->size == st.st_size
+            && cached->mtime.tv_sec == st.st_mtim.tv_sec && cached->mtime.tv_nsec == st.st_mtim.tv_nsec) {
+            ++revalidations_;
+            file = cached;
+        } else {
+            ++misses_;
+            file = openFile(fullPath);
+        }
+    }
+
+    if (cacheSize_ == 0) {
+        return file;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(path);
+    if (!file) {
+        // 文件已经不存在，从缓存中去掉
+        if (it != index_.end()) {
+            EntryList::iterator entry = it->second;
+            index_.erase(it);
+            lru_.erase(entry);
+        }
+        return file;
+    }
+
+    if (it != index_.end()) {
+        it->second->file = file;
+        it->second->validated = now;
+    } else {
+        lru_.push_front(Entry { std::string(path), file, now });
+        index_[lru_.front().path] = lru_.begin();
+        while (lru_.size() > cacheSize_) {
+            index_.erase(lru_.back().path);
+            lru_.pop_back(); // 正在发送的文件由HttpResponse持有引用，发送完才关闭
+        }
+    }
+    return file;
+}
+
+StaticFileHandler::FilePtr StaticFileHandler::openFile(const std::string& fullPath)
+{
+    int fd = ::open(fullPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("StaticFileHandler::openFile %s errno=%d\n", fullPath.c_str(), errno);
+        return FilePtr();
+    }
+
+    std::shared_ptr<File> file(new File);
+    file->fd = fd;
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        return FilePtr(); // file析构时关闭fd
+    }
+    file->size = st.st_size;
+    file->ino = st.st_ino;
+    file->mtime = st.st_mtim;
+
+    char buf[64];
+    // 同一秒内的两次修改长度相同时也要区分，用纳秒精度的修改时间
+    unsigned long long mtimeNs = static_cast<unsigned long long>(st.st_mtim.tv_sec) * 1000000000ULL + st.st_mtim.tv_nsec;
+    snprintf(buf, sizeof buf, "\"%llx-%llx\"", mtimeNs, static_cast<unsigned long long>(st.st_size));
+    file->etag = buf;
+    struct tm tm;
+    ::gmtime_r(&st.st_mtim.tv_sec, &tm);
+    ::strftime(buf, sizeof buf, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    file->lastModified = buf;
+    file->contentType = contentTypeOf(fullPath);
+    return file;
+}
@@ -0,0 +1,99 @@
+#ifndef STATICFILEHANDLER_H
+#define STATICFILEHANDLER_H
+
+#pragma once
+#include <mymuduo/Timestamp.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <unordered_map>
+
+class HttpRequest;
+class HttpResponse;
+
+struct StaticFileStats {
+    int64_t hits = 0; // 缓存命中并且还在有效期内
+    int64_t revalidations = 0; // 缓存过期后重新stat，文件没有变化
+    int64_t misses = 0; // 打开了文件
+};
+
+//
+// 静态文件服务，响应体用TcpConnection::sendFile从page cache直接发送，不读进HttpResponse::body
+// 打开的fd和stat结果放在LRU缓存中，超过ttl后重新stat一次，文件被修改或替换时重新打开，
+// 被淘汰的fd在正在进行的发送完成后才关闭
+// 支持GET和HEAD，If-None-Match/If-Modified-Since命中时回复304，单个区间的Range请求回复206
+// 可以被多个loop线程同时使用
+//
+// StaticFileHandler files("./public");
+// router.get("/static/*filepath", [&files](const HttpRequest& req, const RouteParams& params, HttpResponse* resp) {
+//     files.handle(req, params.get("filepath"), resp);
+// });
+//
+class StaticFileHandler {
+public:
+    static const size_t kDefaultCacheSize = 1024;
+    static constexpr double kDefaultTtlSeconds = 2.0;
+
+    // cacheSize为0时不缓存，每个请求都打开文件
+    explicit StaticFileHandler(const std::string& root,
+        size_t cacheSize = kDefaultCacheSize,
+        double ttlSeconds = kDefaultTtlSeconds);
+    ~StaticFileHandler();
+
+    // path是相对root的路径，为空或者以/结尾时返回其中的index.html，包含..的路径回复404
+    void handle(const HttpRequest& req, std::string_view path, HttpResponse* resp);
+    // 直接把请求路径作为相对root的路径
+    void operator()(const HttpRequest& req, HttpResponse* resp);
+
+    StaticFileStats stats() const;
+
+private:
+    // 打开的文件，最后一个引用释放时关闭fd
+    struct File {
+        ~File();
+
+        int fd;
+        off_t size;
+        ino_t ino;
+        struct timespec mtime;
+        std::string etag;
+        std::string lastModified; // HTTP日期格式
+        const char* contentType;
+    };
+    using FilePtr = std::shared_ptr<const File>;
+
+    struct Entry {
+        std::string path; // 相对root的路径，index_的key指向它
+        FilePtr file;
+        Timestamp validated; // 上次stat的时间
+    };
+    using EntryList = std::list<Entry>;
+
+    // 从缓存中取文件，过期时重新stat，不存在或者不是普通文件时返回nullptr
+    FilePtr getFile(std::string_view path);
+    static FilePtr openFile(const std::string& fullPath);
+    // 304
+    static bool notModified(const HttpRequest& req, const File& file);
+
+    const std::string root_; // 以/结尾
+    const size_t cacheSize_;
+    const double ttlSeconds_;
+
+    std::mutex mutex_;
+    EntryList lru_; // 最近使用的在前面
+    std::unordered_map<std::string_view, EntryList::iterator> index_;
+
+    std::atomic<int64_t> hits_;
+    std::atomic<int64_t> revalidations_;
+    std::atomic<int64_t> misses_;
+};
+
+#endif
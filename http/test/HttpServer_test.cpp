@@ -1,52 +1,45 @@
 #include "../HttpRequest.h"
 #include "../HttpResponse.h"
 #include "../HttpServer.h"
+#include "../Router.h"
 
 #include <cstdlib>
 #include <iostream>
 #include <ostream>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 extern char favicon[555];
 bool benchmark = false;
 
-void onRequest(const HttpRequest& req, HttpResponse* resp)
+void onIndex(const HttpRequest& req, const RouteParams&, HttpResponse* resp)
 {
-    std::cout << "Headers " << req.methodString() << " " << req.path() << std::endl;
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("text/html");
+    resp->addHeader("Server", "MyMuduo");
+    std::string now = Timestamp::now().toString();
+    resp->setBody("<html><head><title>This is title</title></head>"
+                  "<body><h1>Hello</h1>Now is "
+        + now + "</body></html>");
+}
 
-    if (!benchmark) {
-        const std::unordered_map<std::string, std::string>& headers = req.headers();
-        for (const auto& header : headers) {
-            std::cout << header.first << ": " << header.second << std::endl;
-        }
-    }
+void onFavicon(const HttpRequest& req, const RouteParams&, HttpResponse* resp)
+{
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("image/png");
+    resp->setBody(std::string(favicon, sizeof favicon));
+}
 
-    if (req.path() == "/") {
-        resp->setStatusCode(HttpResponse::k200Ok);
-        resp->setStatusMessage("OK");
-        resp->setContentType("text/html");
-        resp->addHeader("Server", "MyMuduo");
-        std::string now = Timestamp::now().toString();
-        resp->setBody("<html><head><title>This is title</title></head>"
-                      "<body><h1>Hello</h1>Now is "
-            + now + "</body></html>");
-    } else if (req.path() == "/favicon.ico") {
-        resp->setStatusCode(HttpResponse::k200Ok);
-        resp->setStatusMessage("OK");
-        resp->setContentType("image/png");
-        resp->setBody(std::string(favicon, sizeof favicon));
-    } else if (req.path() == "/hello") {
-        resp->setStatusCode(HttpResponse::k200Ok);
-        resp->setStatusMessage("OK");
-        resp->setContentType("text/plain");
-        resp->addHeader("Server", "Muduo");
-        resp->setBody("hello, world!\n");
-    } else {
-        resp->setStatusCode(HttpResponse::k404NotFound);
-        resp->setStatusMessage("Not Found");
-        resp->setCloseConnection(true);
-    }
+void onHello(const HttpRequest& req, const RouteParams& params, HttpResponse* resp)
+{
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("text/plain");
+    resp->addHeader("Server", "Muduo");
+    std::string_view name = params.get("name");
+    resp->setBody("hello, " + std::string(name.empty() ? "world" : name) + "!\n");
 }
 
 int main(int argc, char* argv[])
@@ -56,10 +49,25 @@ int main(int argc, char* argv[])
         benchmark = true;
         numThreads = atoi(argv[1]);
     }
+
+    Router router;
+    router.get("/", onIndex);
+    router.get("/favicon.ico", onFavicon);
+    router.get("/hello", onHello);
+    router.get("/hello/:name", onHello);
+
     EventLoop loop;
     InetAddress listenAddr(9000, "192.168.110.132");
     HttpServer server(&loop, listenAddr, "TestHttpServer");
-    server.setHttpCallback(onRequest);
+    server.setHttpCallback([&router](const HttpRequest& req, HttpResponse* resp) {
+        std::cout << "Headers " << req.methodString() << " " << req.path() << std::endl;
+        if (!benchmark) {
+            for (const HttpRequest::Header& header : req.headers()) {
+                std::cout << header.field << ": " << header.value << std::endl;
+            }
+        }
+        router.dispatch(req, resp);
+    });
     server.setThreadNum(numThreads);
     server.start();
     loop.loop();